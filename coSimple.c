@@ -16,15 +16,37 @@
  *
  * This library implements:
  * - NMT master
+ *    => optional node state table @see CO_NMT_TABLE_ENABLE
+ * - heartbeat producer @see CO_HEARTBEAT_ENABLE
+ * - node guarding @see CO_NODE_GUARDING_ENABLE
  * - SYNC producer
  * - EMCY receiver
  * - TIME producer
  * - PDO receive/transmit
  *    => only one PDO for each
+ *    => to many nodes in one transport call @see coTPDOBatch()
  * - SDO client
  *    => only expedited
- *    => only on default channels
+ *    => on default channels, additional ones per node @see CO_SDO_CHANNELS_ENABLE
  *    => only at max 4 byte data types, (u)int8 - (u)int32
+ *    => optional adaptive timeouts per node @see CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+ * - CAN controller bus-off recovery @see CO_RECOVERY_ENABLE
+ * - CiA402 drive state machine @see CO_CIA402_ENABLE
+ * - receive timestamps @see CO_MSG_TIMESTAMP_ENABLE
+ * - setpoint streaming buffers @see CO_SETPOINT_ENABLE
+ * - process image in shared memory @see CO_SHM_ENABLE
+ * - bus sharing with client processes @see CO_MUX_ENABLE
+ * - CiA309-3 ASCII gateway @see CO_GATEWAY_ENABLE
+ * - routing to another bus @see CO_ROUTER_ENABLE
+ * - replay of recorded bus logs @see CO_REPLAY_ENABLE
+ * - offline analysis of recorded bus logs @see CO_TRACE_ENABLE
+ * - compact binary bus log @see CO_BLOG_ENABLE
+ * - fault injection into the transport @see CO_FAULT_ENABLE
+ * - response-time analysis of the bus @see CO_RTA_ENABLE
+ * - redundant operation on two buses @see CO_REDUNDANT_ENABLE
+ * - hot-standby master with state snapshots @see CO_STANDBY_ENABLE
+ * - program download to many nodes at once @see CO_FIRMWARE_ENABLE
+ * - multiplexed PDOs for SDO-free object writes @see CO_MPDO_ENABLE
  *
  * Mode of operation:
  * - reset/reboot node with NMT
@@ -36,6 +58,8 @@
  *   - receive PDO from node    @see coRPDO()
  *   => received EMCY messages in this cyclic mode are forwarded to application
  *   => no SDO transactions supported in cyclic operation!
+ *      except background configuration  @see CO_SDO_ASYNC_ENABLE
+ *   => rebooted nodes can be reconfigured in the background @see CO_HOTPLUG_ENABLE
  *
  */
 
@@ -43,6 +67,10 @@
 #include "coSimple.h"
 #include <assert.h>
 #include <string.h> // memcpy
+#ifdef CO_GATEWAY_ENABLE
+#include <inttypes.h> // PRIu32
+#include <stdio.h>    // snprintf
+#endif
 
 
 /**
@@ -99,283 +127,5341 @@ static inline uint8_t getNodeId(const co_msg_t *msg);
  */
 static inline int haveTimeout(co_t *co, uint32_t start, const uint32_t timeout);
 
+/**
+ * @brief Send SDO request and wait for the matching response.
+ *
+ * A response matches if it is from the addressed node and for the same index
+ * and subindex. With CO_SDO_ADAPTIVE_TIMEOUT_ENABLE the request is repeated on
+ * timeout and the measured round-trip time updates the estimate of the node.
+ * Fails right away if a background transfer uses the channel of the node.
+ *
+ * @param[in] co coSimple instance
+ * @param[in,out] msg SDO request to send, gets overwritten with the response
+ * @return int -1 on error or timeout, 0 on response received
+ */
+static int sdoTransfer(co_t *co, co_msg_t *msg);
 
-int coNMTReq(co_t *co, uint8_t nodeId, co_nmt_state_req_t req) {
-    assert(co);
-    assert(co->tx);
-    assert(nodeId <= 127); // nodeId is allowed to be zero
-    // prepare CAN frame
-    co_msg_t msg = {
-        .cobId = COB_ID_NMT, // NMT node control
-        .len = 2,
-        .data = {req /* requested state */, nodeId /* addressed node */}};
-    // send CAN frame
-    return co->tx(&msg);
-}
+/**
+ * @brief Send SDO request and wait for the matching response, without
+ *        checking for background transfers.
+ *
+ * @param[in] co coSimple instance
+ * @param[in,out] msg SDO request to send, gets overwritten with the response
+ * @return int -1 on error or timeout, 0 on response received
+ */
+static int sdoExchange(co_t *co, co_msg_t *msg);
 
-int coNMTWaitBoot(co_t *co, uint8_t nodeId) {
-    assert(co);
-    assert(co->rx);
-    assert(co->ms);
-    assert(nodeId > 0 && nodeId <= 127);
-    // wait blocking for response but with timeout
-    uint32_t start = co->ms();
-    int ret;
-    co_msg_t msg;
-    while (-1 != (ret = co->rx(&msg))) {
-        // check if this was the frame we are looking for
-        if (COB_ID_HRTB == getCOBIDType(&msg) // received frame was a boot up message (heartbeat)
-            && nodeId == getNodeId(&msg)      // was from the requested node
-            && 1 == msg.len                   // has exactly one byte of data
-            && 0x00 == msg.data[0]) {         // data has NMT state of 0 = boot-up
-            return 0;                         // all good, got boot-up message
-        }
-        // check for timeout
-        if (0 != haveTimeout(co, start, CO_TIMEOUT_NMT)) {
-            return -1; // timeout
-        }
-    }
-    return ret; // forward error of rx callback
-}
+/**
+ * @brief Send a SDO request of this instance.
+ *
+ * Only one transfer may run on the default channel of a node at a time. A
+ * request isn't sent while a client of co_t::mux has a transfer to the node
+ * in progress, or while a blocking transfer to the node is in progress and
+ * the request is of a background transfer. Otherwise the channel is taken
+ * for this instance in co_t::mux. A request that isn't sent counts as lost,
+ * it is repeated on timeout like any other.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] msg the request
+ * @param background 1 if request is of a background transfer, 0 if blocking
+ * @return int -1 on error of co_tx_cb_t, 0 on sent, 1 on channel busy
+ */
+static int sdoTx(co_t *co, const co_msg_t *msg, int background);
 
-int coSYNC(co_t *co) {
-    assert(co);
-    assert(co->tx);
-    // prepare CAN frame
-#ifndef CO_SYNC_COUNTER_ENABLE
-    co_msg_t msg = {
-        .cobId = COB_ID_SYNC, // Sync
-        .len = 0
-        // note: SYNC frame doesn't carry any data
-    };
-#else
-    co_msg_t msg = {
-        .cobId = COB_ID_SYNC, // Sync
-        .len = 1,
-        .data = {co->syncCounter}};
-    // increment SYNC counter
-    ++(co->syncCounter);
+#if defined(CO_SDO_ASYNC_ENABLE) || defined(CO_GATEWAY_ENABLE)
+/**
+ * @brief Check if a background transfer or gateway request uses the default
+ *        channel of a node.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId the node
+ * @return int 0 on channel free, 1 on channel used
+ */
+static int sdoBackground(co_t *co, uint8_t nodeId);
 #endif
-    // send CAN frame
-    return co->tx(&msg);
-}
 
-#ifdef CO_SYNC_COUNTER_ENABLE
-int coSYNCResetCounter(co_t *co) {
-    assert(co);
-    co->syncCounter = 1;
-    return 0; // no error
-}
+#ifdef CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+#define SDO_RETRIES (CO_SDO_RETRIES) //<! count of repetitions of a timed out SDO request
+#else
+#define SDO_RETRIES (0) //<! count of repetitions of a timed out SDO request
 #endif
 
-int coTIME(co_t *co, uint32_t ms) {
-    assert(co);
-    assert(co->tx);
-    assert(co->ms);
-    // get ms counter
-    // does user provide a specific millisecond time value?
-    if (CO_TIME_USE_TIMECB == ms) {
-        // no, get our own
-        ms = co->ms();
-    }
-    // prepare CAN frame
-    // ToDo: implement day field of TIME_OF_DAY data type
-    co_msg_t msg = {
-        .cobId = COB_ID_TIME, // TimeStamp
-        .len = 6,
-        .data = {
-            ms & 0xff, (ms >> 8) & 0xff, (ms >> 16) & 0xff, // miliseconds 24bit
-            0,                                              // reserved 8bits
-            0, 0},                                          // days 16bits, not implemented!
-    };
-    // send CAN frame
-    return co->tx(&msg);
-}
+/**
+ * @brief Prepare an expedited SDO download request.
+ *
+ * @param[out] msg CAN frame to fill
+ * @param nodeId addressed node
+ * @param index object dictionary index
+ * @param subIndex od subindex
+ * @param data value to be set
+ * @param len size of data in \p data, range 1 - 4
+ */
+static void sdoWriteMsg(co_msg_t *msg, uint8_t nodeId, uint16_t index, uint8_t subIndex, uint32_t data,
+                        size_t len);
 
-int coTPDO(co_t *co, uint8_t nodeId, uint8_t *data, size_t len) {
-    assert(co);
-    assert(co->tx);
-    assert(nodeId > 0 && nodeId <= 127);
-    assert(data);
-    assert(len > 0 && len <= 8);
-    // prepare CAN frame
-    co_msg_t msg = {
-        .cobId = COB_ID_RPDO1 + nodeId, // Master Tx, Slave Rx
-        .len = len};
-    // copy data
-    memcpy(msg.data, data, len);
-    // send CAN frame
-    return co->tx(&msg);
-}
+/**
+ * @brief Prepare an expedited SDO upload request.
+ *
+ * @param[out] msg CAN frame to fill
+ * @param nodeId addressed node
+ * @param index object dictionary index
+ * @param subIndex od subindex
+ */
+static void sdoReadMsg(co_msg_t *msg, uint8_t nodeId, uint16_t index, uint8_t subIndex);
 
-int coRPDO(co_t *co, uint8_t nodeId, uint8_t *data, size_t *len) {
-    assert(co);
-    assert(co->rx);
-    assert(co->emcy);
-    assert(nodeId > 0 && nodeId <= 127);
-    assert(data);
-    assert(len);
-    // try to receive a CAN frame
-    co_msg_t msg;
-    int ret = co->rx(&msg);
-    if (0 != ret) {
-        // either no data or error, forward to application
-        return ret;
-    }
-    // we have received something, process it
-    co_cob_id_t cobId = getCOBIDType(&msg);
-    uint8_t rxNodeId = getNodeId(&msg);
-    if (COB_ID_EMCY == cobId) {
-        // emergency, assemble fields and forward to application
-        uint32_t eec = msg.data[0] | (msg.data[1] << 8);
-        co->emcy(rxNodeId, eec, msg.data[2], &msg.data[3]);
-        return 1;
-    } else if (COB_ID_TPDO1 == cobId && nodeId == rxNodeId) {
-        // our looked for PDO, copy data to application
-        *len = msg.len;
-        memcpy(data, msg.data, msg.len);
-        return 0;
-    }
-    // not something we can handle, tell application no data was received
-    return 1;
-}
+/**
+ * @brief Evaluate the response to a SDO download request.
+ *
+ * @param[in] msg the response
+ * @return int -1 on abort or unexpected response, 0 on success
+ */
+static int sdoWriteResult(const co_msg_t *msg);
 
-uint32_t coSDOWrite(co_t *co, uint8_t nodeId, uint16_t index, uint8_t subIndex, uint32_t data, size_t len) {
-    assert(co);
-    assert(co->tx);
-    assert(co->rx);
-    assert(co->ms);
-    assert(nodeId > 0 && nodeId <= 127);
-    assert(len > 0 && len <= 4); // at max (u)int32_t supported!
-    // prepare CAN frame
-    uint8_t nField = ((4 - len) << 2); // count of unused bytes of data part
-    co_msg_t msg = {
-        .cobId = COB_ID_RSDO + nodeId, // receive SDO channel
-        .len = 8,
-        .data = {
-            // client command specifier, SDO client download initiate, expedited, 4 - len unused bytes
-            0x23 | nField,
-            index & 0xff /* index LSB */, (index >> 8) & 0xff /* index MSB */,
-            subIndex,
-            // data, LSB first!
-            data & 0xff,
-            1 < len ? (data >> 8) & 0xff : 0x00,
-            2 < len ? (data >> 16) & 0xff : 0x00,
-            3 < len ? (data >> 24) & 0xff : 0x00}};
-    // send CAN frame
-    int ret = co->tx(&msg);
-    if (0 != ret) {
-        return ret; // error while sending
-    }
-    // wait blocking for response but with timeout
-    uint32_t start = co->ms();
-    while (-1 != (ret = co->rx(&msg))) {
-        // check if this was the frame we are looking for
-        if (COB_ID_TSDO == getCOBIDType(&msg)       // received frame was a SDO response
-            && nodeId == getNodeId(&msg)            // was from the requested node
-            && 8 == msg.len                         // has exactly 8 bytes of data
-            && (index & 0xff) == msg.data[1]        // requested index, low byte
-            && ((index >> 8) & 0xff) == msg.data[2] // requested index, high byte
-            && subIndex == msg.data[3]) {           // requested subindex
-            // this is for us, check status code
-            switch (msg.data[0] & 0xf0) {
-            case 0x20: // ok, finish
-            case 0x60:
-                return 0;
-            case 0x80: // error
-            default:
-                return -1;
-            }
-        }
-        // check for timeout
-        if (0 != haveTimeout(co, start, CO_TIMEOUT_SDO)) {
-            return -1; // timeout
-        }
-    }
-    return ret; // forward error of rx callback
-}
+/**
+ * @brief Evaluate the response to a SDO upload request.
+ *
+ * @param[in] msg the response
+ * @param[out] data read value
+ * @param len expected size of data, range 1 - 4
+ * @return int -1 on abort, unexpected response or size mismatch, 0 on success
+ */
+static int sdoReadResult(const co_msg_t *msg, uint32_t *data, size_t len);
 
-uint32_t coSDORead(co_t *co, uint8_t nodeId, uint16_t index, uint8_t subIndex, uint32_t *data, size_t len) {
-    assert(co);
-    assert(co->tx);
-    assert(co->rx);
-    assert(co->ms);
-    assert(nodeId > 0 && nodeId <= 127);
-    assert(data);
-    assert(len > 0 && len <= 4); // at max (u)int32_t supported!
-    // prepare CAN frame
-    co_msg_t msg = {
-        .cobId = COB_ID_RSDO + nodeId, // receive SDO channel
-        .len = 8,
-        .data = {
-            0x40, // client command specifier, SDO client upload initiate
-            index & 0xff /* index LSB */, (index >> 8) & 0xff /* index MSB */,
-            subIndex
-            // no data
-        }};
-    // send CAN frame
-    int ret = co->tx(&msg);
-    if (0 != ret) {
-        return ret; // error while sending
-    }
-    // wait blocking for response but with timeout
-    uint32_t start = co->ms();
-    uint8_t nField = ((4 - len) << 2); // count of unused bytes of data part
-    while (-1 != (ret = co->rx(&msg))) {
-        // check if this was the frame we are looking for
-        if (COB_ID_TSDO == getCOBIDType(&msg)       // received frame was a SDO response
-            && nodeId == getNodeId(&msg)            // was from the requested node
-            && 8 == msg.len                         // has exactly 8 bytes of data
-            && (index & 0xff) == msg.data[1]        // requested index, low byte
-            && ((index >> 8) & 0xff) == msg.data[2] // requested index, high byte
-            && subIndex == msg.data[3]              // requested subindex
-            && 0x03 == (msg.data[0] & 0x03)         // e[1]=1, s[0]=1
-            && nField == (msg.data[0] & 0x0c)) {    // n[3:2]=count of unused bytes
-            // this is for us, check status code
-            switch (msg.data[0] & 0xf0) {
-            case 0x40: // ok, return
-            case 0x60:
-                *data = msg.data[4] |
-                        ((1 < len) ? (msg.data[5] << 8) : 0x00) |
-                        ((2 < len) ? (msg.data[6] << 16) : 0x00) |
-                        ((3 < len) ? (msg.data[7] << 24) : 0x00);
-                return 0;
-            case 0x80: // error
-            default:
-                return -1;
-            }
-        }
-        // check for timeout
-        if (0 != haveTimeout(co, start, CO_TIMEOUT_SDO)) {
-            return -1; // timeout
-        }
-    }
-    return ret; // forward error of rx callback
-}
+/**
+ * @brief Get the current SDO timeout for a node.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @return uint32_t timeout in ms, CO_TIMEOUT_SDO if not adaptive
+ */
+static uint32_t sdoTimeout(co_t *co, uint8_t nodeId);
 
+/**
+ * @brief Double SDO timeout for a repeated request.
+ *
+ * @param timeout current timeout in ms
+ * @return uint32_t doubled timeout in ms, at max CO_TIMEOUT_SDO_MAX
+ */
+static inline uint32_t sdoBackoff(uint32_t timeout);
 
-static inline co_cob_id_t getCOBIDType(const co_msg_t *msg) {
-    assert(msg);
-    // COB-ID type is in the first four bits, the function code
-    return (msg->cobId & 0b11110000000);
-}
+#ifdef CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+/**
+ * @brief Update round-trip time estimate with a new measurement.
+ *
+ * @param[in,out] rtt estimate to update
+ * @param sample measured round-trip time in ms
+ */
+static void rttUpdate(co_rtt_t *rtt, uint32_t sample);
+#endif
 
-static inline uint8_t getNodeId(const co_msg_t *msg) {
-    assert(msg);
-    // nodeId is in the last seven bits
-    return (msg->cobId & 0b00001111111);
-}
+/**
+ * @brief Receive a frame from the bus.
+ *
+ * Same semantics as co_rx_cb_t. Every frame is passed to co_t::router,
+ * co_t::blog and co_t::mux before anything else can consume it. SDO
+ * responses of transfers of a client are only handed to the client and are
+ * skipped here.
+ *
+ * @param[in] co coSimple instance
+ * @param[out] msg the received CAN frame
+ * @return int -1 on error, 0 on successful reception, 1 on no data
+ */
+static int receive(co_t *co, co_msg_t *msg);
 
-// Source: https://stackoverflow.com/a/3167693 user @nategoose
+/**
+ * @brief Process received frames of background services.
+ *
+ * Every received frame has to pass through here so that background services
+ * can observe the bus, regardless which API call received it.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] msg the received CAN frame
+ * @return int 0 if frame is to be processed further, 1 if frame was consumed
+ */
+static int dispatch(co_t *co, const co_msg_t *msg);
+
+#ifdef CO_NMT_TABLE_ENABLE
+/**
+ * @brief Update NMT state table with a heartbeat or boot-up message.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] msg the received heartbeat
+ */
+static void nmtUpdate(co_t *co, const co_msg_t *msg);
+
+/**
+ * @brief Check if a node confirmed a NMT request.
+ *
+ * @param[in] node table entry of the node
+ * @param req the state change request sent to the node
+ * @param start time in ms the request was sent
+ * @param bootCount boot count of the node before the request was sent
+ * @return int 0 on not yet confirmed, 1 on confirmed
+ */
+static int nmtConfirmed(volatile const co_node_t *node, co_nmt_state_req_t req, uint32_t start,
+                        uint8_t bootCount);
+#endif
+
+#if defined(CO_HEARTBEAT_ENABLE) || defined(CO_NODE_GUARDING_ENABLE)
+/**
+ * @brief Process heartbeat and node guarding deadlines.
+ *
+ * Returns right away if no deadline is due yet.
+ *
+ * @param[in] co coSimple instance
+ */
+static void timerTick(co_t *co);
+
+/**
+ * @brief Get the earlier of two points in time.
+ *
+ * @param a first time in ms
+ * @param b second time in ms
+ * @return uint32_t the earlier time, wrap around safe
+ */
+static inline uint32_t earliest(uint32_t a, uint32_t b);
+#endif
+
+#ifdef CO_NODE_GUARDING_ENABLE
+/**
+ * @brief Process answer to a node guarding request.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] msg the received answer
+ */
+static void guardResponse(co_t *co, const co_msg_t *msg);
+#endif
+
+#if defined(CO_MUX_ENABLE) || defined(CO_BLOG_ENABLE)
+/**
+ * @brief Look at the oldest frame of a ring without taking it.
+ *
+ * @param[in] ring the ring
+ * @param[out] msg copy of the oldest frame
+ * @return int 0 on success, 1 on ring empty
+ */
+static int ringPeek(co_ring_t *ring, co_msg_t *msg);
+
+/**
+ * @brief Drop the oldest frame of a ring.
+ *
+ * @param[in,out] ring the ring, must not be empty
+ */
+static void ringDrop(co_ring_t *ring);
+#endif
+
+#ifdef CO_MUX_ENABLE
+#define MUX_OWNER_SELF (0xff) //<! SDO channel is owned by the instance that owns the bus
+
+/**
+ * @brief Forward a received frame to the clients of a bus-sharing daemon.
+ *
+ * @param[in] co coSimple instance that owns the bus
+ * @param[in,out] mux the daemon
+ * @param[in] msg the received CAN frame
+ * @return int 0 if frame is for the daemon too, 1 if only for a client
+ */
+static int muxForward(co_t *co, co_mux_t *mux, const co_msg_t *msg);
+
+/**
+ * @brief Take the SDO channel of a node for a request.
+ *
+ * @param[in] co coSimple instance that owns the bus
+ * @param[in,out] mux the daemon
+ * @param owner client index + 1 or MUX_OWNER_SELF
+ * @param[in] msg the SDO request
+ * @return int -1 on channel owned by someone else, 0 on success
+ */
+static int muxSdoClaim(co_t *co, co_mux_t *mux, uint8_t owner, const co_msg_t *msg);
+
+/**
+ * @brief Check if a SDO transfer ends with a response.
+ *
+ * @param request command byte of the last request
+ * @param response command byte of the response
+ * @return int 0 on transfer continues, 1 on transfer finished
+ */
+static int muxSdoDone(uint8_t request, uint8_t response);
+#endif
+
+#ifdef CO_ROUTER_ENABLE
+/**
+ * @brief Forward a received frame to the other bus if it has a route.
+ *
+ * @param[in,out] router the router
+ * @param[in] msg the received CAN frame
+ */
+static void routerForward(co_router_t *router, const co_msg_t *msg);
+#endif
+
+#ifdef CO_REPLAY_ENABLE
+/**
+ * @brief Parse one line of a candump or ASC log.
+ *
+ * @param[in] p start of line
+ * @param[in] end end of line, without line feed
+ * @param[out] msg the frame
+ * @param[out] ts timestamp of the frame in ns
+ * @param[out] master frame was sent by the master
+ * @return int -1 on line is no usable frame, 0 on success
+ */
+static int logParse(const char *p, const char *end, co_msg_t *msg, uint64_t *ts, uint8_t *master);
+
+/**
+ * @brief Parse a hex number.
+ *
+ * @param[in,out] p current position, is advanced past the number
+ * @param[in] end end of line
+ * @param[out] value the number
+ * @return size_t count of digits, 0 if none
+ */
+static size_t logHex(const char **p, const char *end, uint32_t *value);
+
+/**
+ * @brief Parse a timestamp in seconds with fraction.
+ *
+ * @param[in,out] p current position, is advanced past the timestamp
+ * @param[in] end end of line
+ * @param[out] ns the timestamp in ns
+ * @return int -1 on error, 0 on success
+ */
+static int logTime(const char **p, const char *end, uint64_t *ns);
+
+/**
+ * @brief Skip spaces and tabs.
+ *
+ * @param[in] p current position
+ * @param[in] end end of line
+ * @return const char* first position that is no space
+ */
+static inline const char *logSpace(const char *p, const char *end);
+
+/**
+ * @brief Check if a frame is one sent by the master.
+ *
+ * @param[in] msg the frame
+ * @param rtr frame is a remote frame
+ * @return int 1 if sent by master, 0 otherwise
+ */
+static int logIsMaster(const co_msg_t *msg, uint8_t rtr);
+
+/**
+ * @brief Read the next frame sent by the master, or by the nodes.
+ *
+ * @param[in,out] log the log
+ * @param[out] msg the frame
+ * @param[out] ts timestamp of the frame in ns
+ * @param master 1 to look for frames of the master, 0 for frames of the nodes
+ * @return int 0 on success, 1 on end of log
+ */
+static int logNextOf(co_log_t *log, co_msg_t *msg, uint64_t *ts, uint8_t master);
+#endif
+
+#ifdef CO_GATEWAY_ENABLE
+/**
+ * @brief Get the next whitespace separated token of a gateway command line.
+ *
+ * @param[in,out] pos current position in line, is advanced past the token
+ * @param[in] end end of line
+ * @param[out] tok start of token
+ * @return size_t length of token, 0 if line has no more tokens
+ */
+static size_t gwToken(const char **pos, const char *end, const char **tok);
+
+/**
+ * @brief Compare a token with a keyword.
+ *
+ * @param[in] tok the token
+ * @param len length of token
+ * @param[in] word null terminated keyword
+ * @return int 1 if equal, 0 otherwise
+ */
+static int gwIs(const char *tok, size_t len, const char *word);
+
+/**
+ * @brief Convert a decimal or hex token to a number.
+ *
+ * @param[in] tok the token
+ * @param len length of token
+ * @param[out] value the number, range -0xffffffff - 0xffffffff
+ * @return int -1 on not a number, 0 on success
+ */
+static int gwNumber(const char *tok, size_t len, int64_t *value);
+
+/**
+ * @brief Format the response line of a gateway command.
+ *
+ * @param[out] resp buffer for response line
+ * @param respLen size of resp
+ * @param[in] cmd the command
+ * @param abort SDO abort code, 0 if none
+ * @param error CiA309-3 error code, 0 if none
+ * @return int -1 on buffer too small, length of response otherwise
+ */
+static int gwFormat(char *resp, size_t respLen, const co_gw_cmd_t *cmd, uint32_t abort, int error);
+
+/**
+ * @brief Send the SDO request of a gateway request.
+ *
+ * @param[in] co coSimple instance
+ * @param[in,out] req the request
+ * @return int -1 on error, 0 on success
+ */
+static int gwSend(co_t *co, co_gw_req_t *req);
+
+/**
+ * @brief Finish a gateway request.
+ *
+ * @param[in,out] req the request
+ * @param abort 0 on success, SDO abort code on error
+ */
+static void gwDone(co_gw_req_t *req, uint32_t abort);
+
+/**
+ * @brief Start waiting gateway requests of nodes that have become free.
+ *
+ * @param[in] co coSimple instance
+ */
+static void gwStart(co_t *co);
+
+/**
+ * @brief Process a SDO response for gateway requests.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] msg the received SDO response
+ * @return int 0 if no gateway request was waiting on it, 1 if consumed
+ */
+static int gwResponse(co_t *co, const co_msg_t *msg);
+
+/**
+ * @brief Remove a gateway request, later requests move up.
+ *
+ * @param[in] co coSimple instance
+ * @param i index of request
+ */
+static void gwRemove(co_t *co, size_t i);
+#endif
+
+#ifdef CO_BLOG_ENABLE
+#define BLOG_HEADER (24) //<! size of block header: magic, size, frames, resolution, timestamp
+#define BLOG_FRAME (23)  //<! max size of an encoded frame
+
+/**
+ * @brief Encode a frame into the block of a binary log.
+ *
+ * @param[in,out] blog the binary log
+ * @param[in] msg the frame
+ * @return int -1 on error while storing a full block, 0 on success
+ */
+static int blogEncode(co_blog_t *blog, const co_msg_t *msg);
+
+/**
+ * @brief Decode the next frame of a binary log.
+ *
+ * @param[in,out] log the log
+ * @param[out] msg the frame
+ * @param[out] rtr frame is a remote frame
+ * @return int -1 on corrupt block, 0 on success, 1 on end of log
+ */
+static int blogDecode(co_log_t *log, co_msg_t *msg, uint8_t *rtr);
+
+/**
+ * @brief Read a little endian number.
+ *
+ * @param[in] p first byte
+ * @param n count of bytes, range 1 - 8
+ * @return uint64_t the number
+ */
+static uint64_t blogGet(const uint8_t *p, size_t n);
+
+/**
+ * @brief Write a little endian number.
+ *
+ * @param[out] p first byte
+ * @param value the number
+ * @param n count of bytes, range 1 - 8
+ */
+static void blogPut(uint8_t *p, uint64_t value, size_t n);
+#endif
+
+#ifdef CO_FAULT_ENABLE
+/**
+ * @brief Get the next pseudo random number, xorshift32.
+ *
+ * @param[in,out] fault the wrapper
+ * @return uint32_t the random number
+ */
+static uint32_t faultRandom(co_fault_t *fault);
+
+/**
+ * @brief Find the rule that injects a fault into a frame.
+ *
+ * Rules are checked in order, the first that hits is returned.
+ *
+ * @param[in,out] fault the wrapper
+ * @param[in,out] msg the frame, is altered by a hitting CO_FAULT_CORRUPT rule
+ * @param dir CO_FAULT_RX or CO_FAULT_TX
+ * @return co_fault_rule_t* the hitting rule, NULL if the frame passes unharmed
+ */
+static co_fault_rule_t *faultMatch(co_fault_t *fault, co_msg_t *msg, uint8_t dir);
+
+/**
+ * @brief Hold back a frame.
+ *
+ * @param[in,out] fault the wrapper
+ * @param[in] msg the frame
+ * @param dir CO_FAULT_RX or CO_FAULT_TX
+ * @param delay time in ms to hold it back
+ * @return int -1 on no space left, 0 on success
+ */
+static int faultHold(co_fault_t *fault, const co_msg_t *msg, uint8_t dir, uint32_t delay);
+
+/**
+ * @brief Send held back frames that are due.
+ *
+ * @param[in,out] fault the wrapper
+ */
+static void faultPumpTx(co_fault_t *fault);
+#endif
+
+#ifdef CO_RTA_ENABLE
+/**
+ * @brief Frame during response-time analysis, all times in ns.
+ */
+typedef struct rta_task_s {
+    uint16_t cobId; //<! priority
+    uint64_t c;     //<! worst-case transmission time
+    uint64_t t;     //<! period
+    uint64_t j;     //<! queuing jitter
+    uint64_t d;     //<! deadline
+} rta_task_t;
+
+/**
+ * @brief Convert a frame for response-time analysis.
+ *
+ * @param[in] frame the frame
+ * @param syncNs SYNC period
+ * @param bitNs duration of a bit in ns
+ * @return rta_task_t the frame with all times in ns
+ */
+static rta_task_t rtaTask(const co_rta_frame_t *frame, uint64_t syncNs, uint64_t bitNs);
+
+/**
+ * @brief Worst-case transmission time of a standard frame with stuff bits.
+ *
+ * @param len size of data, range 0 - 8
+ * @param bitNs duration of a bit in ns
+ * @return uint64_t transmission time in ns
+ */
+static inline uint64_t rtaFrameNs(uint8_t len, uint64_t bitNs);
+
+/**
+ * @brief Compute the worst-case response time of one frame.
+ *
+ * @param[in] frames all frames
+ * @param n count of frames
+ * @param m index of the analyzed frame
+ * @param cyclicNs bus time taken with every SYNC by the SYNC and acyclic traffic
+ * @param blockingNs min blocking by frames of lower priority
+ * @param syncNs SYNC period
+ * @param bitNs duration of a bit in ns
+ * @return uint64_t worst-case response time in ns
+ */
+static uint64_t rtaResponse(const co_rta_frame_t *frames, size_t n, size_t m, uint64_t cyclicNs,
+                            uint64_t blockingNs, uint64_t syncNs, uint64_t bitNs);
+#endif
+
+#ifdef CO_REDUNDANT_ENABLE
+/**
+ * @brief Merge a received frame with the copies of the other bus.
+ *
+ * @param[in,out] red the wrapper
+ * @param[in] msg the received CAN frame
+ * @param b index of the bus that received it
+ * @param now current time in ms
+ * @return int 0 on first copy, 1 on copy of a frame already passed on
+ */
+static int redundantMerge(co_redundant_t *red, const co_msg_t *msg, uint8_t b, uint32_t now);
+
+/**
+ * @brief Count frames whose copy didn't show up in time as lost.
+ *
+ * They are kept as overdue for another CO_REDUNDANT_WINDOW_MS so that a late
+ * copy is still dropped.
+ *
+ * @param[in,out] red the wrapper
+ * @param now current time in ms
+ */
+static void redundantExpire(co_redundant_t *red, uint32_t now);
+#endif
+
+#ifdef CO_STANDBY_ENABLE
+/**
+ * @brief Store a value little endian into a snapshot.
+ *
+ * @param[out] p where to store
+ * @param value the value
+ * @param n count of bytes, range 1 - 4
+ * @return uint8_t* behind the stored value
+ */
+static uint8_t *snapshotPut(uint8_t *p, uint32_t value, size_t n);
+
+/**
+ * @brief Load a little endian value from a snapshot.
+ *
+ * @param[in,out] p where to load from, advanced behind the value
+ * @param[in] end end of the snapshot
+ * @param n count of bytes, range 1 - 4
+ * @param[out] value the value
+ * @return int -1 on end of snapshot, 0 on success
+ */
+static int snapshotGet(const uint8_t **p, const uint8_t *end, size_t n, uint32_t *value);
+
+/**
+ * @brief Parse a snapshot and optionally restore it.
+ *
+ * @param[in,out] co coSimple instance to restore into, NULL to only validate
+ * @param[in] buf the snapshot
+ * @param len size of the snapshot in bytes
+ * @param imageLen expected size of the process image in bytes
+ * @return const uint8_t* start of the process image, NULL on malformed snapshot
+ */
+static const uint8_t *snapshotParse(co_t *co, const uint8_t *buf, size_t len, size_t imageLen);
+#endif
+
+#ifdef CO_FIRMWARE_ENABLE
+/**
+ * @brief Send the request of the current step of a program download.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] fw the download
+ * @param[in,out] node the node, request stays pending if it wasn't sent
+ * @return int -1 if co_tx_cb_t failed, 0 on success
+ */
+static int fwRequest(co_t *co, const co_fw_t *fw, co_fw_node_t *node);
+
+/**
+ * @brief Process a SDO response during a program download.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] fw the download
+ * @param[in,out] node the node that responded
+ * @param[in] msg the response
+ */
+static void fwResponse(co_t *co, const co_fw_t *fw, co_fw_node_t *node, const co_msg_t *msg);
+
+/**
+ * @brief Send the next segment of the current sub-block.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] fw the download
+ * @param[in,out] node the node
+ * @return int -1 if co_tx_cb_t failed or channel is busy, 0 on success
+ */
+static int fwSegment(co_t *co, const co_fw_t *fw, co_fw_node_t *node);
+
+/**
+ * @brief Fail the program download of a node.
+ *
+ * An ongoing block download is aborted towards the node.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] fw the download
+ * @param[in,out] node the node
+ * @param abort SDO abort code
+ */
+static void fwFail(co_t *co, const co_fw_t *fw, co_fw_node_t *node, uint32_t abort);
+
+/**
+ * @brief Compute the CRC of SDO block transfers, CRC-16-CCITT.
+ *
+ * @param[in] data the data
+ * @param len size of data in bytes
+ * @return uint16_t the CRC
+ */
+static uint16_t fwCrc(const uint8_t *data, size_t len);
+#endif
+
+#ifdef CO_MPDO_ENABLE
+/**
+ * @brief Process a received frame as source address mode MPDO.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] msg the frame
+ * @return int 0 if COB-ID is not registered, 1 on consumed
+ */
+static int mpdoReceive(co_t *co, const co_msg_t *msg);
+#endif
+
+#ifdef CO_TRACE_ENABLE
+/**
+ * @brief Add a frame of a log to the statistics.
+ *
+ * @param[in,out] trace the statistics
+ * @param[in] msg the frame
+ * @param ts timestamp of the frame in ns
+ */
+static void traceFrame(co_trace_t *trace, const co_msg_t *msg, uint64_t ts);
+
+/**
+ * @brief Count missed cycles at the end of a SYNC cycle.
+ *
+ * @param[in,out] trace the statistics
+ */
+static void traceCycle(co_trace_t *trace);
+
+/**
+ * @brief Merge latency statistics.
+ *
+ * @param[in,out] lat statistics to merge into
+ * @param[in] other statistics to add
+ */
+static void latencyMerge(co_latency_t *lat, const co_latency_t *other);
+#endif
+
+#if defined(CO_MSG_TIMESTAMP_ENABLE) || defined(CO_TRACE_ENABLE)
+/**
+ * @brief Add a measurement to latency statistics.
+ *
+ * @param[in,out] lat statistics to update
+ * @param ns measured latency in ns
+ */
+static void latencyUpdate(co_latency_t *lat, uint64_t ns);
+#endif
+
+#ifdef CO_SDO_ASYNC_ENABLE
+/**
+ * @brief Start a background SDO transfer in the given job.
+ *
+ * @param[in] co coSimple instance
+ * @param[out] job unused job to start transfer in
+ * @param nodeId addressed node
+ * @param[in] cfg array of configuration entries
+ * @param n count of entries in \p cfg
+ * @return int -1 on error, 0 on success
+ */
+static int sdoAsyncStart(co_t *co, co_sdo_job_t *job, uint8_t nodeId, const co_sdo_cfg_t *cfg, size_t n);
+
+/**
+ * @brief Send the current request of a background SDO transfer.
+ *
+ * @param[in] co coSimple instance
+ * @param[in,out] job the job to send request of
+ * @return int -1 on error, 0 on success
+ */
+static int sdoAsyncSend(co_t *co, co_sdo_job_t *job);
+
+#ifdef CO_SDO_CHANNELS_ENABLE
+/**
+ * @brief Pick a channel of the node that no other background transfer uses.
+ *
+ * @param[in] co coSimple instance
+ * @param[in,out] job the job to pick the channel for
+ * @return int -1 if all channels are in use, 0 on success
+ */
+static int sdoAsyncChannel(co_t *co, co_sdo_job_t *job);
+#endif
+
+/**
+ * @brief Finish a background SDO transfer and notify application.
+ *
+ * @param[in] co coSimple instance
+ * @param[in,out] job the job to finish, is unused afterwards
+ * @param result 0 on success, -1 on error
+ */
+static void sdoAsyncDone(co_t *co, co_sdo_job_t *job, int result);
+
+/**
+ * @brief Process a SDO response for background transfers.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] msg the received SDO response
+ * @return int 0 if no background transfer was waiting on it, 1 if consumed
+ */
+static int sdoAsyncResponse(co_t *co, const co_msg_t *msg);
+
+/**
+ * @brief Check background SDO transfers for timeouts.
+ *
+ * @param[in] co coSimple instance
+ */
+static void sdoAsyncTick(co_t *co);
+
+/**
+ * @brief Get the active background SDO transfer of a node.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @return co_sdo_job_t* active job, NULL if none
+ */
+static co_sdo_job_t *sdoAsyncFind(co_t *co, uint8_t nodeId);
+#endif
+
+#ifdef CO_SDO_CHANNELS_ENABLE
+// COB-IDs the predefined connection set leaves free, CiA 301 restricts all others
+#define SDO_CHANNEL_COB_ID(cobId) (0x680 <= (cobId) && (cobId) <= 0x6df)
+
+/**
+ * @brief Request of a parallel SDO transfer on one channel.
+ */
+typedef struct sdo_slot_s {
+    co_msg_t req;     //<! request in flight
+    size_t entry;     //<! entry of the request, count of entries if idle
+    uint32_t start;   //<! time in ms the request was sent
+    uint32_t timeout; //<! timeout in ms of the request
+    uint8_t attempt;  //<! count of repetitions of the request
+    uint8_t sent;     //<! request was sent, else it counts as lost
+} sdo_slot_t;
+
+/**
+ * @brief Get all SDO channels of a node.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @param[out] channels the channels, the default one first
+ * @return size_t count of channels, at least one
+ */
+static size_t sdoChannelList(co_t *co, uint8_t nodeId, co_sdo_channel_t *channels);
+
+/**
+ * @brief Find the additional SDO channel a response was received on.
+ *
+ * @param[in] co coSimple instance
+ * @param cobId COB-ID of the received frame
+ * @return const co_sdo_channel_t* the channel, NULL if none
+ */
+static const co_sdo_channel_t *sdoChannelFind(co_t *co, uint16_t cobId);
+
+/**
+ * @brief Transfer many entries at once over all SDO channels of a node.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @param[in] cfg entries to transfer
+ * @param[out] data read values, NULL to write the entries
+ * @param n count of entries
+ * @return int -1 on error, abort or timeout, 0 on success
+ */
+static int sdoParallel(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, uint32_t *data, size_t n);
+#endif
+
+#ifdef CO_HOTPLUG_ENABLE
+/**
+ * @brief Handle boot-up message of a node.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId the node that booted
+ */
+static void hotplugBoot(co_t *co, uint8_t nodeId);
+#endif
+
+
+int coNMTReq(co_t *co, uint8_t nodeId, co_nmt_state_req_t req) {
+    assert(co);
+    assert(co->tx);
+    assert(nodeId <= 127); // nodeId is allowed to be zero
+    // prepare CAN frame
+    co_msg_t msg = {
+        .cobId = COB_ID_NMT, // NMT node control
+        .len = 2,
+        .data = {req /* requested state */, nodeId /* addressed node */}};
+#ifdef CO_RECOVERY_ENABLE
+    // remember to send it again after bus-off, after a reset the node is
+    // pre-operational and must not be reset again
+    uint8_t keep = (CO_NMT_RST == req || CO_NMT_RST_COM == req) ? CO_NMT_PRE_OP : req;
+    if (0 == nodeId) {
+        co->nmtLast = keep;
+        memset(co->nmtNodes, 0, sizeof(co->nmtNodes)); // overrides requests to single nodes
+    } else {
+        co->nmtNodes[nodeId - 1] = keep;
+    }
+#endif
+    // send CAN frame
+    return co->tx(&msg);
+}
+
+int coNMTWaitBoot(co_t *co, uint8_t nodeId) {
+    assert(co);
+    assert(co->rx);
+    assert(co->ms);
+    assert(nodeId > 0 && nodeId <= 127);
+    // wait blocking for response but with timeout
+    uint32_t start = co->ms();
+    int ret;
+    co_msg_t msg = {0};
+    while (-1 != (ret = receive(co, &msg))) {
+        uint8_t rtr = 0;
+#ifdef CO_NODE_GUARDING_ENABLE
+        rtr = msg.rtr; // own node guarding request in loopback
+#endif
+        // check if this was the frame we are looking for
+        if (0 == ret                             // a frame was received
+            && COB_ID_HRTB == getCOBIDType(&msg) // received frame was a boot up message (heartbeat)
+            && nodeId == getNodeId(&msg)         // was from the requested node
+            && 0 == rtr                          // is no remote request
+            && 1 == msg.len                      // has exactly one byte of data
+            && 0x00 == msg.data[0]) {            // data has NMT state of 0 = boot-up
+            return 0;                            // all good, got boot-up message
+        } else if (0 == ret) {
+            dispatch(co, &msg); // not for us, let background services see it
+        }
+        // check for timeout
+        if (0 != haveTimeout(co, start, CO_TIMEOUT_NMT)) {
+            return -1; // timeout
+        }
+    }
+    return ret; // forward error of rx callback
+}
+
+#ifdef CO_NMT_TABLE_ENABLE
+co_nmt_state_t coNMTState(co_t *co, uint8_t nodeId) {
+    assert(co);
+    assert(nodeId > 0 && nodeId <= 127);
+    const co_node_t *node = &co->nodes[nodeId - 1];
+    return node->seen ? node->state : CO_NMT_STATE_UNKNOWN;
+}
+
+int coNMTReqConfirm(co_t *co, uint8_t nodeId, co_nmt_state_req_t req, uint32_t timeout) {
+    assert(co);
+    assert(co->rx);
+    assert(co->ms);
+    assert(nodeId > 0 && nodeId <= 127);
+    volatile co_node_t *node = &co->nodes[nodeId - 1]; // may be updated from interrupt
+    uint8_t bootCount = node->bootCount;
+    uint32_t start = co->ms();
+    if (0 != coNMTReq(co, nodeId, req)) {
+        return -1;
+    }
+    int ret;
+    co_msg_t msg = {0};
+    while (-1 != (ret = receive(co, &msg))) {
+        if (0 == ret) {
+            dispatch(co, &msg); // updates the table
+        }
+        if (0 != nmtConfirmed(node, req, start, bootCount)) {
+            return 0;
+        }
+        // check for timeout
+        if (0 != haveTimeout(co, start, timeout)) {
+            return -1; // timeout
+        }
+    }
+    return ret; // forward error of rx callback
+}
+
+int coNMTReqBulk(co_t *co, const co_node_set_t *targets, co_nmt_state_req_t req, uint32_t timeout,
+                 int broadcast, co_node_set_t *stragglers) {
+    assert(co);
+    assert(co->rx);
+    assert(co->ms);
+    assert(targets);
+    assert(stragglers);
+    co_node_set_t pending = *targets;
+    pending.bits[0] &= ~1UL; // there is no node 0
+    // remember boot counts to detect resets, check if broadcast is possible
+    uint8_t bootCount[127];
+    int n = 0;
+    for (uint8_t nodeId = 1; nodeId <= 127; ++nodeId) {
+        const co_node_t *node = &co->nodes[nodeId - 1];
+        bootCount[nodeId - 1] = node->bootCount;
+        if (CO_NODE_SET_HAS(&pending, nodeId)) {
+            ++n;
+        } else if (node->seen) {
+            broadcast = 0; // would also hit a node that is known to not be targeted
+        }
+    }
+    if (0 == n) {
+        *stragglers = pending;
+        return 0; // nothing to do
+    }
+    broadcast = (127 == n) || broadcast;
+    // send requests
+    uint32_t start = co->ms();
+    if (broadcast) {
+        if (0 != coNMTReq(co, 0, req)) {
+            return -1;
+        }
+    } else {
+        for (uint8_t nodeId = 1; nodeId <= 127; ++nodeId) {
+            if (CO_NODE_SET_HAS(&pending, nodeId) && 0 != coNMTReq(co, nodeId, req)) {
+                return -1;
+            }
+        }
+    }
+    // wait for confirmations
+    int ret = 1; // no frame received yet
+    int count;
+    co_msg_t msg = {0};
+    do {
+        if (0 == ret) {
+            dispatch(co, &msg); // updates the table
+        }
+        count = 0;
+        for (uint8_t nodeId = 1; nodeId <= 127; ++nodeId) {
+            if (0 == pending.bits[nodeId >> 5]) {
+                nodeId |= 31; // skip empty word
+                continue;
+            }
+            if (!CO_NODE_SET_HAS(&pending, nodeId)) {
+                continue;
+            }
+            volatile const co_node_t *node = &co->nodes[nodeId - 1]; // may be updated from interrupt
+            if (0 != nmtConfirmed(node, req, start, bootCount[nodeId - 1])) {
+                CO_NODE_SET_DEL(&pending, nodeId);
+            } else {
+                ++count;
+            }
+        }
+        if (0 == count || 0 != haveTimeout(co, start, timeout)) {
+            break; // done or timeout
+        }
+    } while (-1 != (ret = receive(co, &msg)));
+    *stragglers = pending;
+    return (-1 == ret) ? -1 : count;
+}
+#endif
+
+int coSYNC(co_t *co) {
+    assert(co);
+    assert(co->tx);
+#ifdef CO_RECOVERY_ENABLE
+    if (0 != coBusCheck(co)) {
+        return -1; // bus not usable
+    }
+#endif
+    // prepare CAN frame
+#ifndef CO_SYNC_COUNTER_ENABLE
+    co_msg_t msg = {
+        .cobId = COB_ID_SYNC, // Sync
+        .len = 0
+        // note: SYNC frame doesn't carry any data
+    };
+#else
+    co_msg_t msg = {
+        .cobId = COB_ID_SYNC, // Sync
+        .len = 1,
+        .data = {co->syncCounter}};
+    // increment SYNC counter
+    ++(co->syncCounter);
+#endif
+    // send CAN frame
+    int ret = co->tx(&msg);
+    // SYNC is the cyclic tick, check background services after it was sent
+#ifdef CO_SDO_ASYNC_ENABLE
+    sdoAsyncTick(co);
+#endif
+#if defined(CO_HEARTBEAT_ENABLE) || defined(CO_NODE_GUARDING_ENABLE)
+    timerTick(co);
+#endif
+    return ret;
+}
+
+#ifdef CO_HEARTBEAT_ENABLE
+int coHeartbeatProducer(co_t *co, uint8_t nodeId, uint16_t period) {
+    assert(co);
+    assert(co->ms);
+    assert(nodeId > 0 && nodeId <= 127);
+    co->hbNodeId = nodeId;
+    co->hbPeriod = period;
+    co->hbLast = co->ms() - period; // send first heartbeat with next SYNC
+    co->timerNext = co->hbLast;
+    return 0;
+}
+#endif
+
+#ifdef CO_NODE_GUARDING_ENABLE
+int coGuardRegister(co_t *co, uint8_t nodeId, uint16_t guardTime, uint8_t lifeTimeFactor) {
+    assert(co);
+    assert(co->ms);
+    assert(nodeId > 0 && nodeId <= 127);
+    assert(lifeTimeFactor > 0 || 0 == guardTime);
+    co_guard_t *free = NULL;
+    for (size_t i = 0; i < CO_GUARD_NODES; ++i) {
+        if (nodeId == co->guards[i].nodeId) {
+            free = &co->guards[i]; // already registered, replace
+            break;
+        } else if (NULL == free && 0 == co->guards[i].nodeId) {
+            free = &co->guards[i];
+        }
+    }
+    if (0 == guardTime) {
+        if (NULL != free && nodeId == free->nodeId) {
+            free->nodeId = 0; // stop guarding
+        }
+        return 0;
+    } else if (NULL == free) {
+        return -1; // no space left
+    }
+    uint32_t now = co->ms();
+    *free = (co_guard_t){
+        .lastRequest = now - guardTime, // send first request with next SYNC
+        .lastResponse = now,            // life time starts now
+        .guardTime = guardTime,
+        .lifeTimeFactor = lifeTimeFactor,
+        .toggle = 2, // accept any toggle bit on first answer
+        .nodeId = nodeId};
+    co->timerNext = free->lastRequest;
+    return 0;
+}
+#endif
+
+#ifdef CO_RECOVERY_ENABLE
+int coBusCheck(co_t *co) {
+    assert(co);
+    assert(co->status);
+    assert(co->restart);
+    assert(co->rx);
+    assert(co->ms);
+    co_bus_status_t status;
+    if (0 != co->status(&status)) {
+        return -1;
+    }
+    co_bus_state_t last = co->busState;
+    co->busState = status.state;
+    if (CO_BUS_OFF == status.state) {
+        uint32_t now = co->ms();
+        if (CO_BUS_OFF != last) {
+            // bus-off just happened, restart controller
+            ++co->busStats.busOff;
+            co->busOffSince = now;
+            co->busResync = 1;
+        } else if (0 == haveTimeout(co, co->busRestartAt, CO_RECOVERY_RESTART_MS)) {
+            return -1; // still waiting for last restart to complete
+        }
+        co->busRestartAt = now;
+        if (0 != co->restart()) {
+            ++co->busStats.restartErrors; // tried again after CO_RECOVERY_RESTART_MS
+        } else {
+            ++co->busStats.restarts;
+        }
+        return -1;
+    }
+    if (CO_BUS_PASSIVE == status.state && CO_BUS_PASSIVE != last) {
+        ++co->busStats.errorPassive;
+    }
+    if (0 == co->busResync) {
+        return 0; // no recovery in progress
+    }
+    // controller is back, drop frames that were queued before or during
+    // bus-off, but let background services see them (e.g. boot-ups)
+    co_msg_t msg = {0};
+    int ret;
+    while (1 != (ret = receive(co, &msg))) {
+        if (-1 == ret) {
+            return -1;
+        }
+        dispatch(co, &msg);
+    }
+    // resynchronize nodes, they may have missed NMT requests, first the
+    // broadcast then the requests to single nodes that were sent after it
+    co_msg_t nmt = {
+        .cobId = COB_ID_NMT, // NMT node control
+        .len = 2,
+        .data = {co->nmtLast, 0}};
+    if (0 != co->nmtLast && 0 != co->tx(&nmt)) {
+        return -1;
+    }
+    for (size_t i = 0; i < 127; ++i) {
+        if (0 != co->nmtNodes[i]) {
+            nmt.data[0] = co->nmtNodes[i];
+            nmt.data[1] = i + 1;
+            if (0 != co->tx(&nmt)) {
+                return -1;
+            }
+        }
+    }
+#ifdef CO_SYNC_COUNTER_ENABLE
+    coSYNCResetCounter(co);
+#endif
+    co->busResync = 0;
+    uint32_t duration = co->ms() - co->busOffSince;
+    co->busStats.lastRecoveryMs = duration;
+    if (duration > co->busStats.maxRecoveryMs) {
+        co->busStats.maxRecoveryMs = duration;
+    }
+    return 0;
+}
+#endif
+
+#ifdef CO_SYNC_COUNTER_ENABLE
+int coSYNCResetCounter(co_t *co) {
+    assert(co);
+    co->syncCounter = 1;
+    return 0; // no error
+}
+#endif
+
+int coTIME(co_t *co, uint32_t ms) {
+    assert(co);
+    assert(co->tx);
+    assert(co->ms);
+    // get ms counter
+    // does user provide a specific millisecond time value?
+    if (CO_TIME_USE_TIMECB == ms) {
+        // no, get our own
+        ms = co->ms();
+    }
+    // prepare CAN frame
+    // ToDo: implement day field of TIME_OF_DAY data type
+    co_msg_t msg = {
+        .cobId = COB_ID_TIME, // TimeStamp
+        .len = 6,
+        .data = {
+            ms & 0xff, (ms >> 8) & 0xff, (ms >> 16) & 0xff, // miliseconds 24bit
+            0,                                              // reserved 8bits
+            0, 0},                                          // days 16bits, not implemented!
+    };
+    // send CAN frame
+    return co->tx(&msg);
+}
+
+int coTPDO(co_t *co, uint8_t nodeId, uint8_t *data, size_t len) {
+    assert(co);
+    assert(co->tx);
+    assert(nodeId > 0 && nodeId <= 127);
+    assert(data);
+    assert(len > 0 && len <= 8);
+    // prepare CAN frame
+    co_msg_t msg = {
+        .cobId = COB_ID_RPDO1 + nodeId, // Master Tx, Slave Rx
+        .len = len};
+    // copy data
+    memcpy(msg.data, data, len);
+    // send CAN frame
+    return co->tx(&msg);
+}
+
+int coTPDOBatch(co_t *co, const uint8_t *nodeIds, const uint8_t *data, size_t stride, size_t len,
+                size_t n) {
+    assert(co);
+    assert(co->tx || co->txBatch);
+    assert(nodeIds || 0 == n);
+    assert(data || 0 == n);
+    assert(len > 0 && len <= 8);
+    co_msg_t msgs[CO_TPDO_BATCH];
+    for (size_t done = 0; done < n;) {
+        size_t count = (n - done < CO_TPDO_BATCH) ? n - done : CO_TPDO_BATCH;
+        // prepare CAN frames
+        for (size_t i = 0; i < count; ++i) {
+            assert(nodeIds[done + i] > 0 && nodeIds[done + i] <= 127);
+            msgs[i] = (co_msg_t){
+                .cobId = COB_ID_RPDO1 + nodeIds[done + i], // Master Tx, Slave Rx
+                .len = len};
+            memcpy(msgs[i].data, data + (done + i) * stride, len);
+        }
+        // send CAN frames
+        if (co->txBatch) {
+            if (0 != co->txBatch(msgs, count)) {
+                return -1;
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                if (0 != co->tx(&msgs[i])) {
+                    return -1;
+                }
+            }
+        }
+        done += count;
+    }
+    return 0;
+}
+
+int coRPDO(co_t *co, uint8_t nodeId, uint8_t *data, size_t *len) {
+    assert(co);
+    assert(co->rx);
+    assert(co->emcy);
+    assert(nodeId > 0 && nodeId <= 127);
+    assert(data);
+    assert(len);
+    // try to receive a CAN frame
+    co_msg_t msg = {0}; // fields the rx callback doesn't set stay 0
+    int ret = receive(co, &msg);
+    if (0 != ret) {
+        // either no data or error, forward to application
+        return ret;
+    }
+    // we have received something, process it
+    if (0 != dispatch(co, &msg)) {
+        return 1; // consumed by background service
+    }
+    co_cob_id_t cobId = getCOBIDType(&msg);
+    uint8_t rxNodeId = getNodeId(&msg);
+    if (COB_ID_EMCY == cobId) {
+        // emergency, assemble fields and forward to application
+        uint32_t eec = msg.data[0] | (msg.data[1] << 8);
+        co->emcy(rxNodeId, eec, msg.data[2], &msg.data[3]);
+        return 1;
+    } else if (COB_ID_TPDO1 == cobId && nodeId == rxNodeId) {
+        // our looked for PDO, copy data to application
+        *len = msg.len;
+        memcpy(data, msg.data, msg.len);
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+        co->pdoTs[nodeId - 1] = msg.ts;
+#endif
+        return 0;
+    }
+    // not something we can handle, tell application no data was received
+    return 1;
+}
+
+uint32_t coSDOWrite(co_t *co, uint8_t nodeId, uint16_t index, uint8_t subIndex, uint32_t data, size_t len) {
+    assert(co);
+    assert(co->tx);
+    assert(co->rx);
+    assert(co->ms);
+    assert(nodeId > 0 && nodeId <= 127);
+    assert(len > 0 && len <= 4); // at max (u)int32_t supported!
+    // prepare CAN frame
+    co_msg_t msg;
+    sdoWriteMsg(&msg, nodeId, index, subIndex, data, len);
+    // send CAN frame and wait for response
+    if (0 != sdoTransfer(co, &msg)) {
+        return -1; // error while sending or timeout
+    }
+    // check status code
+    return (0 == sdoWriteResult(&msg)) ? 0 : -1;
+}
+
+uint32_t coSDORead(co_t *co, uint8_t nodeId, uint16_t index, uint8_t subIndex, uint32_t *data, size_t len) {
+    assert(co);
+    assert(co->tx);
+    assert(co->rx);
+    assert(co->ms);
+    assert(nodeId > 0 && nodeId <= 127);
+    assert(data);
+    assert(len > 0 && len <= 4); // at max (u)int32_t supported!
+    // prepare CAN frame
+    co_msg_t msg;
+    sdoReadMsg(&msg, nodeId, index, subIndex);
+    // send CAN frame and wait for response
+    if (0 != sdoTransfer(co, &msg)) {
+        return -1; // error while sending or timeout
+    }
+    // check status code
+    return (0 == sdoReadResult(&msg, data, len)) ? 0 : -1;
+}
+
+
+uint32_t coSDOWriteBatch(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, size_t n) {
+    assert(co);
+    assert(cfg || 0 == n);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t ret = coSDOWrite(co, nodeId, cfg[i].index, cfg[i].subIndex, cfg[i].data, cfg[i].len);
+        if (0 != ret) {
+            return ret; // abort on first error
+        }
+    }
+    return 0;
+}
+
+uint32_t coSDOConfigFingerprint(const co_sdo_cfg_t *cfg, size_t n) {
+    assert(cfg || 0 == n);
+    uint32_t hash = 0x811c9dc5; // FNV-1a offset basis
+    for (size_t i = 0; i < n; ++i) {
+        // hash the fields as they are sent on the bus, independent of padding
+        uint8_t bytes[8] = {
+            cfg[i].index & 0xff, (cfg[i].index >> 8) & 0xff,
+            cfg[i].subIndex,
+            cfg[i].len,
+            cfg[i].data & 0xff, (cfg[i].data >> 8) & 0xff,
+            (cfg[i].data >> 16) & 0xff, (cfg[i].data >> 24) & 0xff};
+        for (size_t j = 0; j < sizeof(bytes); ++j) {
+            hash ^= bytes[j];
+            hash *= 0x01000193; // FNV-1a prime
+        }
+    }
+    return (0 == hash) ? 1 : hash; // zero is reserved for "not configured"
+}
+
+int coSDOConfigure(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, size_t n) {
+    assert(co);
+    assert(cfg || 0 == n);
+    uint32_t fingerprint = coSDOConfigFingerprint(cfg, n);
+    // compare with stored verify configuration, skip if equal
+    uint32_t date = 0, time = 0;
+    int verify = (0 == coSDOReadU32(co, nodeId, 0x1020, 0x01, &date)
+                  && 0 == coSDOReadU32(co, nodeId, 0x1020, 0x02, &time));
+    if (verify && fingerprint == date && n == time) {
+        return 1; // already configured
+    }
+    // invalidate stored verify configuration, an interrupted configuration
+    // must not look valid
+    if (verify
+        && (0 != coSDOWriteU32(co, nodeId, 0x1020, 0x01, 0)
+            || 0 != coSDOWriteU32(co, nodeId, 0x1020, 0x02, 0))) {
+        return -1;
+    }
+    // write configuration
+    if (0 != coSDOWriteBatch(co, nodeId, cfg, n)) {
+        return -1;
+    }
+    // remember configuration
+    if (verify
+        && (0 != coSDOWriteU32(co, nodeId, 0x1020, 0x01, fingerprint)
+            || 0 != coSDOWriteU32(co, nodeId, 0x1020, 0x02, n))) {
+        return -1;
+    }
+    return 0;
+}
+
+#ifdef CO_CIA402_ENABLE
+size_t co402Update(const uint16_t *restrict statusword, uint16_t *restrict controlword,
+                   const uint8_t *restrict target, uint8_t *restrict state, size_t n) {
+    assert(statusword || 0 == n);
+    assert(controlword || 0 == n);
+    assert(target || 0 == n);
+    assert(state || 0 == n);
+    // The loop body is written branch free, conditions are multiplied instead
+    // of used in if or ?:, so that the compiler can vectorize it.
+    uint32_t changed = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint16_t sw = statusword[i];
+        uint16_t cw = controlword[i];
+        uint16_t prev = state[i];
+        // decode state from statusword bits 0 - 3, 5 and 6
+        uint16_t s4f = sw & 0x4f;
+        uint16_t s6f = sw & 0x6f;
+        uint16_t notReady = (0x00 == s4f);
+        uint16_t disabled = (0x40 == s4f);
+        uint16_t ready = (0x21 == s6f);
+        uint16_t switchedOn = (0x23 == s6f);
+        uint16_t enabled = (0x27 == s6f);
+        uint16_t quickStop = (0x07 == s6f);
+        uint16_t reaction = (0x0f == s4f);
+        uint16_t fault = (0x08 == s4f);
+        uint16_t valid = notReady | disabled | ready | switchedOn | enabled | quickStop | reaction | fault;
+        uint16_t s = disabled * CO_402_SWITCH_ON_DISABLED
+                     + ready * CO_402_READY
+                     + switchedOn * CO_402_SWITCHED_ON
+                     + enabled * CO_402_OP_ENABLED
+                     + quickStop * CO_402_QUICK_STOP
+                     + reaction * CO_402_FAULT_REACTION
+                     + fault * CO_402_FAULT
+                     + (1 - valid) * prev; // invalid statusword, keep last state
+        // select command that leads one step closer to target
+        uint16_t toEnabled = (CO_402_TARGET_ENABLED == target[i]);
+        uint16_t toQuickStop = (CO_402_TARGET_QUICK_STOP == target[i]);
+        uint16_t cmd = toEnabled * (disabled * 0x06                 // shutdown
+                                    + ready * 0x07                  // switch on
+                                    + (switchedOn | enabled) * 0x0f // enable operation
+                                    + fault * (~cw & 0x80))         // toggle fault reset for a rising edge
+                       + toQuickStop * (ready | switchedOn | enabled | quickStop) * 0x02; // quick stop
+        // everything else, including target disabled: disable voltage = 0x00
+        controlword[i] = (cw & ~0x008f) | cmd;
+        changed += (s != prev);
+        state[i] = s;
+    }
+    return changed;
+}
+#endif
+
+#ifdef CO_SETPOINT_ENABLE
+int coSetpointPush(co_setpoint_t *sp, int32_t position) {
+    assert(sp);
+    static_assert(0 == (CO_SETPOINT_FIFO & (CO_SETPOINT_FIFO - 1)), "CO_SETPOINT_FIFO not a power of two");
+    unsigned head = atomic_load_explicit(&sp->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&sp->tail, memory_order_acquire);
+    if (CO_SETPOINT_FIFO == head - tail) {
+        return -1; // full
+    }
+    sp->fifo[head & (CO_SETPOINT_FIFO - 1)] = position;
+    atomic_store_explicit(&sp->head, head + 1, memory_order_release); // publish
+    return 0;
+}
+
+size_t coSetpointFree(co_setpoint_t *sp) {
+    assert(sp);
+    unsigned head = atomic_load_explicit(&sp->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&sp->tail, memory_order_acquire);
+    return CO_SETPOINT_FIFO - (head - tail);
+}
+
+int coSetpointPop(co_setpoint_t *sp, int32_t *position) {
+    assert(sp);
+    assert(position);
+    unsigned tail = atomic_load_explicit(&sp->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&sp->head, memory_order_acquire);
+    if (head != tail) {
+        int32_t next = sp->fifo[tail & (CO_SETPOINT_FIFO - 1)];
+        atomic_store_explicit(&sp->tail, tail + 1, memory_order_release); // free entry
+        // first setpoint or first one after a hold has no meaningful delta
+        sp->delta = sp->primed ? next - sp->last : 0;
+        sp->primed = 1;
+        sp->last = next;
+        sp->missed = 0;
+        *position = next;
+        return 0;
+    }
+    // underrun
+    ++sp->underruns;
+    if (CO_SP_EXTRAPOLATE == sp->policy && sp->missed < CO_SETPOINT_EXTRAPOLATE_MAX) {
+        sp->last += sp->delta; // continue with last velocity
+    } else {
+        sp->primed = 0; // hold
+    }
+    if (sp->missed < UINT8_MAX) {
+        ++sp->missed;
+    }
+    *position = sp->last;
+    return 1;
+}
+#endif
+
+#ifdef CO_SHM_ENABLE
+#ifdef CO_NMT_TABLE_ENABLE
+#define SHM_NODES_LEN (sizeof(((co_t *)0)->nodes)) //<! size of node table in co_shm_t
+#else
+#define SHM_NODES_LEN (0) //<! size of node table in co_shm_t
+#endif
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+#define SHM_TS_LEN (sizeof(((co_t *)0)->pdoTs)) //<! size of PDO timestamps in co_shm_t
+#else
+#define SHM_TS_LEN (0) //<! size of PDO timestamps in co_shm_t
+#endif
+
+size_t coShmSize(size_t imageLen) {
+    return sizeof(co_shm_t) + SHM_NODES_LEN + SHM_TS_LEN + imageLen;
+}
+
+int coShmInit(co_shm_t *shm, size_t imageLen) {
+    assert(shm);
+    if (imageLen > UINT32_MAX) {
+        return -1;
+    }
+    shm->magic = 0; // invalid until fully initialized
+    atomic_store_explicit(&shm->seq, 0, memory_order_relaxed);
+    shm->layout = CO_SHM_LAYOUT;
+    shm->nodesLen = SHM_NODES_LEN;
+    shm->tsLen = SHM_TS_LEN;
+    shm->imageLen = imageLen;
+    memset(shm->data, 0, SHM_NODES_LEN + SHM_TS_LEN + imageLen);
+    atomic_thread_fence(memory_order_release);
+    shm->magic = CO_SHM_MAGIC;
+    return 0;
+}
+
+void coShmPublish(co_t *co, co_shm_t *shm, const void *image) {
+    assert(co);
+    assert(shm && CO_SHM_MAGIC == shm->magic);
+    assert(image || 0 == shm->imageLen);
+    unsigned seq = atomic_load_explicit(&shm->seq, memory_order_relaxed);
+    atomic_store_explicit(&shm->seq, seq + 1, memory_order_relaxed); // odd, writing
+    atomic_thread_fence(memory_order_release);
+#ifdef CO_NMT_TABLE_ENABLE
+    memcpy(shm->data, co->nodes, SHM_NODES_LEN);
+#endif
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+    memcpy(shm->data + SHM_NODES_LEN, co->pdoTs, SHM_TS_LEN);
+#endif
+    (void)co;
+    memcpy(shm->data + SHM_NODES_LEN + SHM_TS_LEN, image, shm->imageLen);
+    atomic_store_explicit(&shm->seq, seq + 2, memory_order_release); // even, done
+}
+
+int coShmRead(const co_shm_t *shm, void *image, void *nodes, void *pdoTs, uint32_t *version) {
+    assert(shm);
+    assert(image || 0 == shm->imageLen);
+    if (CO_SHM_MAGIC != shm->magic || CO_SHM_LAYOUT != shm->layout) {
+        return -1;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    for (unsigned attempt = 0; attempt < CO_SHM_READ_RETRIES; ++attempt) {
+        unsigned begin = atomic_load_explicit((atomic_uint *)&shm->seq, memory_order_acquire);
+        if (begin & 1) {
+            continue; // writer is active
+        }
+        if (nodes) {
+            memcpy(nodes, shm->data, shm->nodesLen);
+        }
+        if (pdoTs) {
+            memcpy(pdoTs, shm->data + shm->nodesLen, shm->tsLen);
+        }
+        memcpy(image, shm->data + shm->nodesLen + shm->tsLen, shm->imageLen);
+        atomic_thread_fence(memory_order_acquire);
+        unsigned end = atomic_load_explicit((atomic_uint *)&shm->seq, memory_order_relaxed);
+        if (begin == end) {
+            if (version) {
+                *version = begin / 2;
+            }
+            return 0;
+        }
+    }
+    return 1; // writer doesn't finish, it may have died while updating
+}
+#endif
+
+#if defined(CO_MUX_ENABLE) || defined(CO_BLOG_ENABLE)
+int coRingTx(co_ring_t *ring, const co_msg_t *msg) {
+    assert(ring);
+    assert(msg);
+    static_assert(0 == (CO_RING_SIZE & (CO_RING_SIZE - 1)), "CO_RING_SIZE must be a power of two");
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (CO_RING_SIZE == head - tail) {
+        return -1; // full
+    }
+    ring->msgs[head & (CO_RING_SIZE - 1)] = *msg;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release); // publish
+    return 0;
+}
+
+int coRingRx(co_ring_t *ring, co_msg_t *msg) {
+    assert(ring);
+    assert(msg);
+    if (0 != ringPeek(ring, msg)) {
+        return 1; // empty
+    }
+    ringDrop(ring);
+    return 0;
+}
+
+static int ringPeek(co_ring_t *ring, co_msg_t *msg) {
+    assert(ring);
+    assert(msg);
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (head == tail) {
+        return 1; // empty
+    }
+    *msg = ring->msgs[tail & (CO_RING_SIZE - 1)];
+    return 0;
+}
+
+static void ringDrop(co_ring_t *ring) {
+    assert(ring);
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release); // free entry
+}
+#endif
+
+#ifdef CO_MUX_ENABLE
+int coMuxAttach(co_mux_t *mux, co_mux_client_t *client) {
+    assert(mux);
+    assert(client);
+    for (size_t i = 0; i < CO_MUX_CLIENTS; ++i) {
+        if (NULL == mux->clients[i]) {
+            atomic_store(&client->rx.head, 0);
+            atomic_store(&client->rx.tail, 0);
+            atomic_store(&client->tx.head, 0);
+            atomic_store(&client->tx.tail, 0);
+            client->dropped = 0;
+            mux->clients[i] = client;
+            return 0;
+        }
+    }
+    return -1; // no space left
+}
+
+void coMuxDetach(co_mux_t *mux, co_mux_client_t *client) {
+    assert(mux);
+    assert(client);
+    for (size_t i = 0; i < CO_MUX_CLIENTS; ++i) {
+        if (client != mux->clients[i]) {
+            continue;
+        }
+        mux->clients[i] = NULL;
+        for (size_t n = 0; n < 127; ++n) {
+            if (i + 1 == mux->sdoOwner[n]) {
+                mux->sdoOwner[n] = 0; // release SDO channel
+            }
+        }
+    }
+}
+
+int coMuxPoll(co_t *co, co_mux_t *mux) {
+    assert(co);
+    assert(co->tx);
+    assert(co->ms);
+    assert(mux);
+    // release SDO channels of transfers that went silent
+    for (size_t n = 0; n < 127; ++n) {
+        if (0 != mux->sdoOwner[n] && 0 != haveTimeout(co, mux->sdoSince[n], CO_TIMEOUT_SDO)) {
+            mux->sdoOwner[n] = 0;
+        }
+    }
+    // send frames of clients
+    for (size_t i = 0; i < CO_MUX_CLIENTS; ++i) {
+        co_mux_client_t *client = mux->clients[i];
+        if (NULL == client || !atomic_load_explicit(&client->active, memory_order_acquire)) {
+            continue;
+        }
+        co_msg_t msg;
+        while (0 == ringPeek(&client->tx, &msg)) {
+            co_cob_id_t cobId = getCOBIDType(&msg);
+            uint8_t nodeId = getNodeId(&msg);
+            if ((COB_ID_SYNC == cobId && 0 == nodeId) || COB_ID_RPDO1 == cobId) {
+                ringDrop(&client->tx); // cyclic traffic belongs to the daemon
+                continue;
+            }
+            if (0 != muxSdoClaim(co, mux, i + 1, &msg)) {
+                break; // SDO channel busy, keep request queued
+            }
+            if (0 != co->tx(&msg)) {
+                return -1; // frame stays queued, try again with next poll
+            }
+            ringDrop(&client->tx);
+        }
+    }
+    return 0;
+}
+
+
+static int muxForward(co_t *co, co_mux_t *mux, const co_msg_t *msg) {
+    assert(co);
+    assert(mux);
+    assert(msg);
+    co_cob_id_t cobId = getCOBIDType(msg);
+    uint8_t nodeId = getNodeId(msg);
+    if (COB_ID_TSDO == cobId && 0 < nodeId) {
+        // SDO response only goes to the owner of the channel
+        uint8_t owner = mux->sdoOwner[nodeId - 1];
+        if (0 == owner) {
+            return 0; // no transfer in progress
+        }
+        mux->sdoSince[nodeId - 1] = co->ms();
+        if (0 != muxSdoDone(mux->sdoRequest[nodeId - 1], msg->data[0])) {
+            mux->sdoOwner[nodeId - 1] = 0; // release channel
+        }
+        if (MUX_OWNER_SELF == owner) {
+            return 0; // for the daemon itself
+        }
+        if (NULL != mux->clients[owner - 1] && 0 != coRingTx(&mux->clients[owner - 1]->rx, msg)) {
+            ++mux->clients[owner - 1]->dropped;
+        }
+        return 1;
+    }
+    if ((COB_ID_SYNC == cobId && 0 == nodeId) || COB_ID_TPDO1 == cobId) {
+        return 0; // cyclic traffic stays in the daemon
+    }
+    // everything else goes to all clients
+    for (size_t i = 0; i < CO_MUX_CLIENTS; ++i) {
+        co_mux_client_t *client = mux->clients[i];
+        if (NULL != client
+            && atomic_load_explicit(&client->active, memory_order_acquire)
+            && 0 != coRingTx(&client->rx, msg)) {
+            ++client->dropped;
+        }
+    }
+    return 0;
+}
+
+static int muxSdoClaim(co_t *co, co_mux_t *mux, uint8_t owner, const co_msg_t *msg) {
+    assert(co);
+    assert(mux);
+    assert(msg);
+    uint8_t nodeId = getNodeId(msg);
+    if (COB_ID_RSDO != getCOBIDType(msg) || 0 == nodeId) {
+        return 0; // not a SDO request
+    }
+    uint8_t *current = &mux->sdoOwner[nodeId - 1];
+    if (0 != *current && owner != *current) {
+        return -1; // channel busy
+    }
+    uint8_t *request = &mux->sdoRequest[nodeId - 1];
+    int block = (owner == *current && 0xc0 == (*request & 0xe0));
+    if (!block) {
+        *request = msg->data[0]; // segments of a block download are no commands
+    }
+    *current = owner;
+    mux->sdoSince[nodeId - 1] = co->ms();
+    if (block ? 0x80 == msg->data[0] : 0x80 == (msg->data[0] & 0xe0)) {
+        *current = 0; // abort ends the transfer
+    }
+    return 0;
+}
+
+static int muxSdoDone(uint8_t request, uint8_t response) {
+    if (0x80 == (response & 0xe0)) {
+        return 1; // abort
+    }
+    switch (request & 0xe0) {
+    case 0x20: // initiate download, done if expedited
+        return 0 != (request & 0x02);
+    case 0x00: // download segment, done if last segment
+        return 0 != (request & 0x01);
+    case 0x40: // initiate upload, done if response is expedited
+        return 0 != (response & 0x02);
+    case 0x60: // upload segment, done if response is last segment
+        return 0 != (response & 0x01);
+    case 0xc0: // block download, done on end response
+        return 0xa1 == response;
+    default: // block upload, released by timeout
+        return 0;
+    }
+}
+#endif
+
+
+static inline co_cob_id_t getCOBIDType(const co_msg_t *msg) {
+    assert(msg);
+    // COB-ID type is in the first four bits, the function code
+    return (msg->cobId & 0b11110000000);
+}
+
+static inline uint8_t getNodeId(const co_msg_t *msg) {
+    assert(msg);
+    // nodeId is in the last seven bits
+    return (msg->cobId & 0b00001111111);
+}
+
+// Source: https://stackoverflow.com/a/3167693 user @nategoose
 static inline int haveTimeout(co_t *co, uint32_t start, const uint32_t timeout) {
     assert(co);
-    assert(timeout < (UINT32_MAX / 2));
-    uint32_t now = co->ms();
-    int32_t delta = now - start;
-    uint32_t duration = delta < 0 ? -delta : delta; // abs(delta)
-    if (duration >= timeout) {
-        return -1; // timeout
+    assert(timeout < (UINT32_MAX / 2));
+    uint32_t now = co->ms();
+    int32_t delta = now - start;
+    uint32_t duration = delta < 0 ? -delta : delta; // abs(delta)
+    if (duration >= timeout) {
+        return -1; // timeout
+    } else {
+        return 0; // ok
+    }
+}
+
+static int sdoTransfer(co_t *co, co_msg_t *msg) {
+    assert(co);
+    assert(msg);
+#if defined(CO_SDO_ASYNC_ENABLE) || defined(CO_GATEWAY_ENABLE)
+    uint8_t nodeId = getNodeId(msg);
+    if (0 != sdoBackground(co, nodeId)) {
+        return -1; // channel is used by a background transfer
+    }
+    co->sdoNode = nodeId; // keep background transfers off the channel
+    int ret = sdoExchange(co, msg);
+    co->sdoNode = 0;
+    return ret;
+#else
+    return sdoExchange(co, msg);
+#endif
+}
+
+static int sdoExchange(co_t *co, co_msg_t *msg) {
+    assert(co);
+    assert(msg);
+    const co_msg_t req = *msg; // msg gets overwritten by rx, keep request for retries
+    uint8_t nodeId = getNodeId(&req);
+    uint32_t timeout = sdoTimeout(co, nodeId);
+    for (int attempt = 0; attempt <= SDO_RETRIES; ++attempt) {
+        if (0 < attempt) {
+            timeout = sdoBackoff(timeout);
+        }
+        // send CAN frame
+        int sent = sdoTx(co, &req, 0);
+        if (-1 == sent) {
+            return -1; // error while sending
+        }
+        // wait blocking for response but with timeout
+        uint32_t start = co->ms();
+        int ret;
+        while (-1 != (ret = receive(co, msg))) {
+            // check if this was the frame we are looking for
+            if (0 == ret                            // a frame was received
+                && 0 == sent                        // request was sent, channel is ours
+                && COB_ID_TSDO == getCOBIDType(msg) // received frame was a SDO response
+                && nodeId == getNodeId(msg)         // was from the requested node
+                && 8 == msg->len                    // has exactly 8 bytes of data
+                && req.data[1] == msg->data[1]      // requested index, low byte
+                && req.data[2] == msg->data[2]      // requested index, high byte
+                && req.data[3] == msg->data[3]) {   // requested subindex
+#ifdef CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+                // Karn's algorithm: don't sample repeated requests, the
+                // response could belong to any of them
+                if (0 == attempt) {
+                    uint32_t rtt = co->ms() - start;
+                    rttUpdate(&co->rtt[nodeId - 1], rtt);
+                    rttUpdate(&co->rttBus, rtt);
+                }
+#endif
+                return 0; // got response
+            } else if (0 == ret) {
+                dispatch(co, msg); // not for us, let background services see it
+            }
+            // check for timeout
+            if (0 != haveTimeout(co, start, timeout)) {
+                break; // timeout, retry if allowed
+            }
+        }
+        if (-1 == ret) {
+            return -1; // forward error of rx callback
+        }
+    }
+    return -1; // timeout
+}
+
+static int sdoTx(co_t *co, const co_msg_t *msg, int background) {
+    assert(co);
+    assert(co->tx);
+    assert(msg);
+    uint8_t nodeId = getNodeId(msg);
+    if (COB_ID_RSDO == getCOBIDType(msg) && 0 < nodeId) {
+#if defined(CO_SDO_ASYNC_ENABLE) || defined(CO_GATEWAY_ENABLE)
+        if (background && nodeId == co->sdoNode) {
+            return 1; // blocking transfer in progress
+        }
+#endif
+#ifdef CO_MUX_ENABLE
+        if (co->mux && 0 != muxSdoClaim(co, co->mux, MUX_OWNER_SELF, msg)) {
+            return 1; // a client has a transfer in progress
+        }
+#endif
+    }
+    (void)background;
+    return (0 != co->tx(msg)) ? -1 : 0;
+}
+
+#if defined(CO_SDO_ASYNC_ENABLE) || defined(CO_GATEWAY_ENABLE)
+static int sdoBackground(co_t *co, uint8_t nodeId) {
+    assert(co);
+#ifdef CO_SDO_ASYNC_ENABLE
+    for (size_t i = 0; i < CO_SDO_ASYNC_JOBS; ++i) {
+        const co_sdo_job_t *job = &co->sdoJobs[i];
+        if (NULL != job->cfg && nodeId == job->nodeId
+#ifdef CO_SDO_CHANNELS_ENABLE
+            && COB_ID_RSDO + nodeId == job->channel.request
+#endif
+        ) {
+            return 1;
+        }
+    }
+#endif
+#ifdef CO_GATEWAY_ENABLE
+    for (size_t i = 0; i < CO_GATEWAY_REQUESTS; ++i) {
+        if (2 == co->gwReqs[i].state && nodeId == co->gwReqs[i].cmd.nodeId) {
+            return 1;
+        }
+    }
+#endif
+    return 0;
+}
+#endif
+
+static void sdoWriteMsg(co_msg_t *msg, uint8_t nodeId, uint16_t index, uint8_t subIndex, uint32_t data,
+                        size_t len) {
+    assert(msg);
+    assert(nodeId > 0 && nodeId <= 127);
+    assert(len > 0 && len <= 4); // at max (u)int32_t supported!
+    uint8_t nField = ((4 - len) << 2); // count of unused bytes of data part
+    *msg = (co_msg_t){
+        .cobId = COB_ID_RSDO + nodeId, // receive SDO channel
+        .len = 8,
+        .data = {
+            // client command specifier, SDO client download initiate, expedited, 4 - len unused bytes
+            0x23 | nField,
+            index & 0xff /* index LSB */, (index >> 8) & 0xff /* index MSB */,
+            subIndex,
+            // data, LSB first!
+            data & 0xff,
+            1 < len ? (data >> 8) & 0xff : 0x00,
+            2 < len ? (data >> 16) & 0xff : 0x00,
+            3 < len ? (data >> 24) & 0xff : 0x00}};
+}
+
+static void sdoReadMsg(co_msg_t *msg, uint8_t nodeId, uint16_t index, uint8_t subIndex) {
+    assert(msg);
+    assert(nodeId > 0 && nodeId <= 127);
+    *msg = (co_msg_t){
+        .cobId = COB_ID_RSDO + nodeId, // receive SDO channel
+        .len = 8,
+        .data = {
+            0x40, // client command specifier, SDO client upload initiate
+            index & 0xff /* index LSB */, (index >> 8) & 0xff /* index MSB */,
+            subIndex
+            // no data
+        }};
+}
+
+static int sdoWriteResult(const co_msg_t *msg) {
+    assert(msg);
+    switch (msg->data[0] & 0xf0) {
+    case 0x20: // ok, finish
+    case 0x60:
+        return 0;
+    case 0x80: // error
+    default:
+        return -1;
+    }
+}
+
+static int sdoReadResult(const co_msg_t *msg, uint32_t *data, size_t len) {
+    assert(msg);
+    assert(data);
+    assert(len > 0 && len <= 4); // at max (u)int32_t supported!
+    uint8_t nField = ((4 - len) << 2); // count of unused bytes of data part
+    switch (msg->data[0] & 0xf0) {
+    case 0x40: // ok, return
+    case 0x60:
+        if (0x03 != (msg->data[0] & 0x03)        // e[1]=1, s[0]=1
+            || nField != (msg->data[0] & 0x0c)) { // n[3:2]=count of unused bytes
+            return -1;                            // not expedited or size mismatch
+        }
+        *data = msg->data[4] |
+                ((1 < len) ? (msg->data[5] << 8) : 0x00) |
+                ((2 < len) ? (msg->data[6] << 16) : 0x00) |
+                ((3 < len) ? ((uint32_t)msg->data[7] << 24) : 0x00);
+        return 0;
+    case 0x80: // error
+    default:
+        return -1;
+    }
+}
+
+static inline uint32_t sdoBackoff(uint32_t timeout) {
+    return (timeout * 2 < CO_TIMEOUT_SDO_MAX) ? timeout * 2 : CO_TIMEOUT_SDO_MAX;
+}
+
+static uint32_t sdoTimeout(co_t *co, uint8_t nodeId) {
+    assert(co);
+    assert(nodeId > 0 && nodeId <= 127);
+#ifndef CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+    (void)co;
+    (void)nodeId;
+    return CO_TIMEOUT_SDO;
+#else
+    const co_rtt_t *rtt = &co->rtt[nodeId - 1];
+    if (0 == rtt->rttvar) {
+        // node never answered, fall back to estimate of whole bus
+        rtt = &co->rttBus;
+        if (0 == rtt->rttvar) {
+            return CO_TIMEOUT_SDO; // nothing known yet
+        }
+    }
+    // RTO = SRTT + 4 * RTTVAR, rttvar is already scaled by 4
+    uint32_t timeout = (rtt->srtt >> 3) + rtt->rttvar;
+    if (timeout < CO_TIMEOUT_SDO_MIN) {
+        timeout = CO_TIMEOUT_SDO_MIN;
+    } else if (timeout > CO_TIMEOUT_SDO_MAX) {
+        timeout = CO_TIMEOUT_SDO_MAX;
+    }
+    return timeout;
+#endif
+}
+
+#ifdef CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+static void rttUpdate(co_rtt_t *rtt, uint32_t sample) {
+    assert(rtt);
+    if (sample > CO_TIMEOUT_SDO_MAX) {
+        sample = CO_TIMEOUT_SDO_MAX; // keep scaled values within 16 bits
+    }
+    if (0 == rtt->rttvar) {
+        // first measurement, SRTT = R, RTTVAR = R / 2
+        rtt->srtt = sample << 3;
+        rtt->rttvar = sample << 1;
+        if (0 == rtt->rttvar) {
+            rtt->rttvar = 1; // mark as valid, can't decay back to zero
+        }
+        return;
+    }
+    // RTTVAR = 3/4 * RTTVAR + 1/4 * |SRTT - R|
+    int32_t err = (int32_t)sample - (rtt->srtt >> 3);
+    rtt->srtt += err; // SRTT = 7/8 * SRTT + 1/8 * R
+    if (err < 0) {
+        err = -err;
+    }
+    rtt->rttvar += err - (rtt->rttvar >> 2);
+}
+#endif
+
+static int receive(co_t *co, co_msg_t *msg) {
+    assert(co);
+    assert(co->rx);
+    assert(msg);
+    int ret;
+    for (;;) {
+        ret = co->rx(msg);
+        if (0 != ret) {
+            break;
+        }
+#ifdef CO_ROUTER_ENABLE
+        if (co->router) {
+            routerForward(co->router, msg);
+        }
+#endif
+#ifdef CO_BLOG_ENABLE
+        if (co->blog) {
+            coBlogRecord(co->blog, msg);
+        }
+#endif
+#ifdef CO_MUX_ENABLE
+        // SDO responses of a client are only handed to it, receive the next frame
+        if (co->mux && 0 != muxForward(co, co->mux, msg)) {
+            continue;
+        }
+#endif
+        break;
+    }
+    return ret;
+}
+
+static int dispatch(co_t *co, const co_msg_t *msg) {
+    assert(co);
+    assert(msg);
+    co_cob_id_t cobId = getCOBIDType(msg);
+    uint8_t nodeId = getNodeId(msg);
+    if (COB_ID_SYNC == cobId && 0 == nodeId) {
+        // own SYNC in loopback, not an EMCY
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+        co->syncTs = msg->ts;
+#endif
+        return 1;
+    }
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+    if (COB_ID_TPDO1 == cobId && 0 != co->syncTs && 0 != msg->ts && msg->ts >= co->syncTs) {
+        latencyUpdate(&co->pdoLatency, msg->ts - co->syncTs);
+    }
+#endif
+#ifdef CO_SDO_CHANNELS_ENABLE
+    if (NULL != sdoChannelFind(co, msg->cobId)) {
+#ifdef CO_SDO_ASYNC_ENABLE
+        sdoAsyncResponse(co, msg);
+#endif
+        return 1; // response on an additional channel
+    }
+#endif
+#ifdef CO_MPDO_ENABLE
+    if (0 != mpdoReceive(co, msg)) {
+        return 1;
+    }
+#endif
+#ifdef CO_SDO_ASYNC_ENABLE
+    if (COB_ID_TSDO == cobId && 0 != sdoAsyncResponse(co, msg)) {
+        return 1;
+    }
+#endif
+#ifdef CO_GATEWAY_ENABLE
+    if (COB_ID_TSDO == cobId && 0 != gwResponse(co, msg)) {
+        return 1;
+    }
+#endif
+#ifdef CO_NODE_GUARDING_ENABLE
+    if (COB_ID_HRTB == cobId && msg->rtr) {
+        return 1; // own node guarding request in loopback, no node state
+    }
+#endif
+    if (COB_ID_HRTB == cobId && 0 < nodeId && 1 == msg->len) {
+#ifdef CO_NMT_TABLE_ENABLE
+        nmtUpdate(co, msg);
+#endif
+#ifdef CO_NODE_GUARDING_ENABLE
+        guardResponse(co, msg);
+#endif
+#ifdef CO_SDO_CHANNELS_ENABLE
+        if (0x00 == msg->data[0]) {
+            coSDOChannelForget(co, nodeId); // node is back at its defaults
+        }
+#endif
+#ifdef CO_HOTPLUG_ENABLE
+        if (0x00 == msg->data[0]) {
+            hotplugBoot(co, nodeId); // boot-up message
+        }
+#endif
+        return 1; // heartbeat or boot-up message
+    }
+    (void)co;
+    (void)nodeId;
+    return 0;
+}
+
+#ifdef CO_NMT_TABLE_ENABLE
+static void nmtUpdate(co_t *co, const co_msg_t *msg) {
+    assert(co);
+    assert(co->ms);
+    assert(msg);
+    co_node_t *node = &co->nodes[getNodeId(msg) - 1];
+    node->state = msg->data[0] & 0x7f; // mask toggle bit of node guarding
+    node->lastSeen = co->ms();
+    node->seen = 1;
+    if (CO_NMT_STATE_BOOT == node->state) {
+        ++node->bootCount;
+    }
+}
+
+static int nmtConfirmed(volatile const co_node_t *node, co_nmt_state_req_t req, uint32_t start,
+                        uint8_t bootCount) {
+    assert(node);
+    if (CO_NMT_RST == req || CO_NMT_RST_COM == req) {
+        return bootCount != node->bootCount; // wait for boot-up
+    }
+    co_nmt_state_t expected = (CO_NMT_OP == req)     ? CO_NMT_STATE_OP
+                              : (CO_NMT_STOP == req) ? CO_NMT_STATE_STOPPED
+                                                     : CO_NMT_STATE_PRE_OP;
+    return node->seen
+           && expected == node->state
+           && 0 <= (int32_t)(node->lastSeen - start); // reported after request
+}
+#endif
+
+#if defined(CO_HEARTBEAT_ENABLE) || defined(CO_NODE_GUARDING_ENABLE)
+static void timerTick(co_t *co) {
+    assert(co);
+    assert(co->tx);
+    assert(co->ms);
+    uint32_t now = co->ms();
+    if ((int32_t)(now - co->timerNext) < 0) {
+        return; // nothing due yet
+    }
+    uint32_t next = now + UINT16_MAX; // longer than any period
+#ifdef CO_HEARTBEAT_ENABLE
+    if (0 != co->hbPeriod) {
+        if (0 != haveTimeout(co, co->hbLast, co->hbPeriod)) {
+            co_msg_t msg = {
+                .cobId = COB_ID_HRTB + co->hbNodeId, // heartbeat
+                .len = 1,
+                .data = {0x05}}; // master is always operational
+            co->tx(&msg);
+            co->hbLast = now;
+        }
+        next = earliest(next, co->hbLast + co->hbPeriod);
+    }
+#endif
+#ifdef CO_NODE_GUARDING_ENABLE
+    for (size_t i = 0; i < CO_GUARD_NODES; ++i) {
+        co_guard_t *g = &co->guards[i];
+        if (0 == g->nodeId) {
+            continue; // unused
+        }
+        // send guarding request
+        if (0 != haveTimeout(co, g->lastRequest, g->guardTime)) {
+            co_msg_t msg = {
+                .cobId = COB_ID_HRTB + g->nodeId, // node guarding
+                .len = 1,
+                .rtr = 1};
+            co->tx(&msg);
+            g->lastRequest = now;
+        }
+        next = earliest(next, g->lastRequest + g->guardTime);
+        // supervise life time
+        if (!g->lost) {
+            uint32_t lifeTime = (uint32_t)g->guardTime * g->lifeTimeFactor;
+            if (0 != haveTimeout(co, g->lastResponse, lifeTime)) {
+                g->lost = 1;
+                if (co->guard) {
+                    co->guard(g->nodeId, CO_GUARD_LOST);
+                }
+            } else {
+                next = earliest(next, g->lastResponse + lifeTime);
+            }
+        }
+    }
+#endif
+    co->timerNext = next;
+}
+
+static inline uint32_t earliest(uint32_t a, uint32_t b) {
+    return ((int32_t)(a - b) < 0) ? a : b;
+}
+#endif
+
+#ifdef CO_NODE_GUARDING_ENABLE
+static void guardResponse(co_t *co, const co_msg_t *msg) {
+    assert(co);
+    assert(co->ms);
+    assert(msg);
+    if (msg->rtr) {
+        return; // own request in loopback, not an answer
+    }
+    uint8_t nodeId = getNodeId(msg);
+    for (size_t i = 0; i < CO_GUARD_NODES; ++i) {
+        co_guard_t *g = &co->guards[i];
+        if (nodeId != g->nodeId) {
+            continue;
+        }
+        if (0x00 == msg->data[0]) {
+            g->toggle = 0; // boot-up, toggle bit starts again with 0
+            return;
+        }
+        uint8_t toggle = msg->data[0] >> 7;
+        if (2 != g->toggle && toggle != g->toggle) {
+            if (co->guard) {
+                co->guard(nodeId, CO_GUARD_TOGGLE);
+            }
+            return; // not a valid answer
+        }
+        g->toggle = !toggle;
+        g->lastResponse = co->ms();
+        if (g->lost) {
+            g->lost = 0;
+            co->timerNext = g->lastResponse; // reschedule life time supervision
+            if (co->guard) {
+                co->guard(nodeId, CO_GUARD_RESUMED);
+            }
+        }
+        return;
+    }
+}
+#endif
+
+#if defined(CO_MSG_TIMESTAMP_ENABLE) || defined(CO_TRACE_ENABLE)
+static void latencyUpdate(co_latency_t *lat, uint64_t ns) {
+    assert(lat);
+    uint32_t sample = (ns < UINT32_MAX) ? ns : UINT32_MAX;
+    if (0 == lat->count || sample < lat->minNs) {
+        lat->minNs = sample;
+    }
+    if (sample > lat->maxNs) {
+        lat->maxNs = sample;
+    }
+    lat->sumNs += sample;
+    ++lat->count;
+}
+#endif
+
+#ifdef CO_SDO_ASYNC_ENABLE
+int coSDOWriteBatchAsync(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, size_t n) {
+    assert(co);
+    assert(co->tx);
+    assert(co->ms);
+    assert(nodeId > 0 && nodeId <= 127);
+    assert(cfg);
+    assert(n > 0);
+#ifndef CO_SDO_CHANNELS_ENABLE
+    if (NULL != sdoAsyncFind(co, nodeId)) {
+        return -1; // only one transfer per node
+    }
+#endif
+    for (size_t i = 0; i < CO_SDO_ASYNC_JOBS; ++i) {
+        if (NULL == co->sdoJobs[i].cfg) {
+            return sdoAsyncStart(co, &co->sdoJobs[i], nodeId, cfg, n);
+        }
+    }
+    return -1; // all jobs in use
+}
+
+int coSDOAsyncBusy(co_t *co, uint8_t nodeId) {
+    assert(co);
+    assert(nodeId > 0 && nodeId <= 127);
+    return (NULL != sdoAsyncFind(co, nodeId));
+}
+
+static int sdoAsyncStart(co_t *co, co_sdo_job_t *job, uint8_t nodeId, const co_sdo_cfg_t *cfg, size_t n) {
+    assert(co);
+    assert(job);
+    *job = (co_sdo_job_t){
+        .cfg = cfg,
+        .n = n,
+        .pos = 0,
+        .timeout = sdoTimeout(co, nodeId),
+        .nodeId = nodeId};
+#ifdef CO_SDO_CHANNELS_ENABLE
+    if (0 != sdoAsyncChannel(co, job)) {
+        job->cfg = NULL; // one transfer per channel
+        return -1;
+    }
+#endif
+    if (0 != sdoAsyncSend(co, job)) {
+        job->cfg = NULL; // release job again
+        return -1;
+    }
+    return 0;
+}
+
+static int sdoAsyncSend(co_t *co, co_sdo_job_t *job) {
+    assert(co);
+    assert(job);
+    assert(job->cfg && job->pos < job->n);
+    const co_sdo_cfg_t *entry = &job->cfg[job->pos];
+    co_msg_t msg;
+    sdoWriteMsg(&msg, job->nodeId, entry->index, entry->subIndex, entry->data, entry->len);
+#ifdef CO_SDO_CHANNELS_ENABLE
+    msg.cobId = job->channel.request;
+#endif
+    job->start = co->ms();
+    return (-1 == sdoTx(co, &msg, 1)) ? -1 : 0; // not sent is repeated on timeout
+}
+
+static void sdoAsyncDone(co_t *co, co_sdo_job_t *job, int result) {
+    assert(co);
+    assert(job);
+    uint8_t nodeId = job->nodeId;
+    job->cfg = NULL; // release job first, callback may start a new one
+#ifdef CO_HOTPLUG_ENABLE
+    if (0 == result && job->hotplug) {
+        // node is configured again, resume cyclic operation
+        result = coNMTReq(co, nodeId, CO_NMT_OP);
+    }
+#endif
+    if (co->sdoDone) {
+        co->sdoDone(nodeId, result);
+    }
+}
+
+static int sdoAsyncResponse(co_t *co, const co_msg_t *msg) {
+    assert(co);
+    assert(msg);
+#ifdef CO_SDO_CHANNELS_ENABLE
+    co_sdo_job_t *job = NULL;
+    for (size_t i = 0; i < CO_SDO_ASYNC_JOBS; ++i) {
+        if (NULL != co->sdoJobs[i].cfg && msg->cobId == co->sdoJobs[i].channel.response) {
+            job = &co->sdoJobs[i];
+        }
+    }
+#else
+    co_sdo_job_t *job = sdoAsyncFind(co, getNodeId(msg));
+#endif
+    if (NULL == job) {
+        return 0; // no background transfer on this channel
+    }
+    const co_sdo_cfg_t *entry = &job->cfg[job->pos];
+    if (8 != msg->len
+        || (entry->index & 0xff) != msg->data[1]
+        || ((entry->index >> 8) & 0xff) != msg->data[2]
+        || entry->subIndex != msg->data[3]) {
+        return 1; // stale response of a previous request, drop it
+    }
+    if (0x60 != (msg->data[0] & 0xe0)) {
+        sdoAsyncDone(co, job, -1); // abort or unexpected response
+        return 1;
+    }
+#ifdef CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+    if (0 == job->attempt) {
+        // Karn's algorithm, same as blocking transfers
+        uint32_t rtt = co->ms() - job->start;
+        rttUpdate(&co->rtt[job->nodeId - 1], rtt);
+        rttUpdate(&co->rttBus, rtt);
+    }
+#endif
+    // continue with next entry
+    if (++job->pos >= job->n) {
+        sdoAsyncDone(co, job, 0);
+        return 1;
+    }
+    job->attempt = 0;
+    job->timeout = sdoTimeout(co, job->nodeId);
+    if (0 != sdoAsyncSend(co, job)) {
+        sdoAsyncDone(co, job, -1);
+    }
+    return 1;
+}
+
+static void sdoAsyncTick(co_t *co) {
+    assert(co);
+    for (size_t i = 0; i < CO_SDO_ASYNC_JOBS; ++i) {
+        co_sdo_job_t *job = &co->sdoJobs[i];
+        if (NULL == job->cfg || 0 == haveTimeout(co, job->start, job->timeout)) {
+            continue; // unused or still waiting
+        }
+        if (++job->attempt > SDO_RETRIES) {
+            sdoAsyncDone(co, job, -1); // timeout
+            continue;
+        }
+        // repeat request
+        job->timeout = sdoBackoff(job->timeout);
+        if (0 != sdoAsyncSend(co, job)) {
+            sdoAsyncDone(co, job, -1);
+        }
+    }
+}
+
+static co_sdo_job_t *sdoAsyncFind(co_t *co, uint8_t nodeId) {
+    assert(co);
+    for (size_t i = 0; i < CO_SDO_ASYNC_JOBS; ++i) {
+        if (NULL != co->sdoJobs[i].cfg && nodeId == co->sdoJobs[i].nodeId) {
+            return &co->sdoJobs[i];
+        }
+    }
+    return NULL;
+}
+
+#ifdef CO_SDO_CHANNELS_ENABLE
+static int sdoAsyncChannel(co_t *co, co_sdo_job_t *job) {
+    assert(co);
+    assert(job);
+    co_sdo_channel_t channels[1 + CO_SDO_CHANNELS];
+    size_t n = sdoChannelList(co, job->nodeId, channels);
+    for (size_t c = 0; c < n; ++c) {
+        int used = 0;
+        for (size_t i = 0; i < CO_SDO_ASYNC_JOBS; ++i) {
+            const co_sdo_job_t *other = &co->sdoJobs[i];
+            if (other != job && NULL != other->cfg && channels[c].response == other->channel.response) {
+                used = 1;
+            }
+        }
+        if (!used) {
+            job->channel = channels[c];
+            return 0;
+        }
+    }
+    return -1;
+}
+#endif
+#endif
+
+#ifdef CO_SDO_CHANNELS_ENABLE
+int coSDOChannelAdd(co_t *co, uint8_t nodeId, uint8_t n, uint16_t request, uint16_t response) {
+    assert(co);
+    assert(nodeId > 0 && nodeId <= 127);
+    assert(n > 0 && n <= 127);
+    assert(request <= 0x7ff && response <= 0x7ff);
+    if (request == response || !SDO_CHANNEL_COB_ID(request) || !SDO_CHANNEL_COB_ID(response)) {
+        return -1; // COB-IDs clash with each other or the predefined connection set
+    }
+    co_sdo_channel_t *unused = NULL;
+    for (size_t i = 0; i < CO_SDO_CHANNELS; ++i) {
+        co_sdo_channel_t *channel = &co->sdoChannels[i];
+        if (0 == channel->nodeId) {
+            unused = channel;
+        } else if (response == channel->response || request == channel->request
+                   || response == channel->request || request == channel->response) {
+            return -1; // COB-ID already in use
+        }
+    }
+    if (NULL == unused) {
+        return -1; // no space left
+    }
+    // COB-IDs may only be changed while the channel is invalid, bit 31
+    uint16_t index = 0x1200 + n;
+    if (0 != coSDOWriteU32(co, nodeId, index, 0x01, 0x80000000 | request)
+        || 0 != coSDOWriteU32(co, nodeId, index, 0x02, 0x80000000 | response)
+        || 0 != coSDOWriteU32(co, nodeId, index, 0x01, request)
+        || 0 != coSDOWriteU32(co, nodeId, index, 0x02, response)) {
+        return -1;
+    }
+    *unused = (co_sdo_channel_t){
+        .request = request,
+        .response = response,
+        .nodeId = nodeId};
+    return 0;
+}
+
+void coSDOChannelForget(co_t *co, uint8_t nodeId) {
+    assert(co);
+    assert(nodeId > 0 && nodeId <= 127);
+    for (size_t i = 0; i < CO_SDO_CHANNELS; ++i) {
+        if (nodeId == co->sdoChannels[i].nodeId) {
+            co->sdoChannels[i].nodeId = 0;
+        }
+    }
+}
+
+uint32_t coSDOReadParallel(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, uint32_t *data, size_t n) {
+    assert(data || 0 == n);
+    return (0 == sdoParallel(co, nodeId, cfg, data, n)) ? 0 : -1;
+}
+
+uint32_t coSDOWriteParallel(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, size_t n) {
+    return (0 == sdoParallel(co, nodeId, cfg, NULL, n)) ? 0 : -1;
+}
+
+static size_t sdoChannelList(co_t *co, uint8_t nodeId, co_sdo_channel_t *channels) {
+    assert(co);
+    assert(nodeId > 0 && nodeId <= 127);
+    assert(channels);
+    size_t n = 0;
+    channels[n++] = (co_sdo_channel_t){
+        .request = COB_ID_RSDO + nodeId,
+        .response = COB_ID_TSDO + nodeId,
+        .nodeId = nodeId};
+    for (size_t i = 0; i < CO_SDO_CHANNELS; ++i) {
+        if (nodeId == co->sdoChannels[i].nodeId) {
+            channels[n++] = co->sdoChannels[i];
+        }
+    }
+    return n;
+}
+
+static const co_sdo_channel_t *sdoChannelFind(co_t *co, uint16_t cobId) {
+    assert(co);
+    for (size_t i = 0; i < CO_SDO_CHANNELS; ++i) {
+        const co_sdo_channel_t *channel = &co->sdoChannels[i];
+        if (0 != channel->nodeId && cobId == channel->response) {
+            return channel;
+        }
+    }
+    return NULL;
+}
+
+static int sdoParallel(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, uint32_t *data, size_t n) {
+    assert(co);
+    assert(co->tx);
+    assert(co->rx);
+    assert(co->ms);
+    assert(nodeId > 0 && nodeId <= 127);
+    assert(cfg || 0 == n);
+    co_sdo_channel_t channels[1 + CO_SDO_CHANNELS];
+    sdo_slot_t slots[1 + CO_SDO_CHANNELS];
+    size_t listed = sdoChannelList(co, nodeId, channels);
+    size_t k = 0;
+    for (size_t c = 0; c < listed; ++c) {
+        // leave channels of background transfers alone
+        int used = 0;
+#if defined(CO_SDO_ASYNC_ENABLE) || defined(CO_GATEWAY_ENABLE)
+        used = (0 == c && 0 != sdoBackground(co, nodeId));
+#endif
+#ifdef CO_SDO_ASYNC_ENABLE
+        for (size_t i = 0; i < CO_SDO_ASYNC_JOBS; ++i) {
+            const co_sdo_job_t *job = &co->sdoJobs[i];
+            if (NULL != job->cfg && channels[c].response == job->channel.response) {
+                used = 1;
+            }
+        }
+#endif
+        if (!used) {
+            channels[k++] = channels[c];
+        }
+    }
+    if (0 == k && 0 < n) {
+        return -1; // all channels are busy
+    }
+    for (size_t c = 0; c < k; ++c) {
+        slots[c].entry = n; // idle
+    }
+    uint32_t timeout = sdoTimeout(co, nodeId);
+    size_t next = 0;    // next entry to request
+    size_t pending = 0; // count of requests in flight
+    for (;;) {
+        // keep a request in flight on every idle channel
+        for (size_t c = 0; c < k && next < n; ++c) {
+            sdo_slot_t *slot = &slots[c];
+            if (n != slot->entry) {
+                continue;
+            }
+            const co_sdo_cfg_t *entry = &cfg[next];
+            if (data) {
+                sdoReadMsg(&slot->req, nodeId, entry->index, entry->subIndex);
+            } else {
+                sdoWriteMsg(&slot->req, nodeId, entry->index, entry->subIndex, entry->data, entry->len);
+            }
+            slot->req.cobId = channels[c].request;
+            slot->entry = next++;
+            slot->attempt = 0;
+            slot->timeout = timeout;
+            slot->start = co->ms();
+            int sent = sdoTx(co, &slot->req, 0);
+            if (-1 == sent) {
+                return -1; // error while sending
+            }
+            slot->sent = (0 == sent);
+            ++pending;
+        }
+        if (0 == pending) {
+            return 0; // all done
+        }
+        co_msg_t msg = {0};
+        int ret = receive(co, &msg);
+        if (-1 == ret) {
+            return -1; // forward error of rx callback
+        }
+        if (0 == ret) {
+            // find the channel waiting for this frame
+            size_t c = 0;
+            for (; c < k; ++c) {
+                const co_msg_t *req = &slots[c].req;
+                if (n != slots[c].entry                  // a request is in flight
+                    && slots[c].sent                     // request was sent, channel is ours
+                    && channels[c].response == msg.cobId // received on its channel
+                    && 8 == msg.len                      // has exactly 8 bytes of data
+                    && req->data[1] == msg.data[1]       // requested index, low byte
+                    && req->data[2] == msg.data[2]       // requested index, high byte
+                    && req->data[3] == msg.data[3]) {    // requested subindex
+                    break;
+                }
+            }
+            if (c == k) {
+                dispatch(co, &msg); // not for us, let background services see it
+            } else {
+                sdo_slot_t *slot = &slots[c];
+#ifdef CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+                if (0 == slot->attempt) {
+                    // Karn's algorithm, same as blocking transfers
+                    uint32_t rtt = co->ms() - slot->start;
+                    rttUpdate(&co->rtt[nodeId - 1], rtt);
+                    rttUpdate(&co->rttBus, rtt);
+                }
+#endif
+                int result = data ? sdoReadResult(&msg, &data[slot->entry], cfg[slot->entry].len)
+                                  : sdoWriteResult(&msg);
+                if (0 != result) {
+                    return -1; // abort on first error
+                }
+                slot->entry = n;
+                --pending;
+            }
+        }
+        // repeat timed out requests
+        for (size_t c = 0; c < k; ++c) {
+            sdo_slot_t *slot = &slots[c];
+            if (n == slot->entry || 0 == haveTimeout(co, slot->start, slot->timeout)) {
+                continue; // idle or still waiting
+            }
+            if (++slot->attempt > SDO_RETRIES) {
+                return -1; // timeout
+            }
+            slot->timeout = sdoBackoff(slot->timeout);
+            slot->start = co->ms();
+            int sent = sdoTx(co, &slot->req, 0);
+            if (-1 == sent) {
+                return -1; // error while sending
+            }
+            slot->sent = (0 == sent);
+        }
+    }
+}
+#endif
+
+#ifdef CO_HOTPLUG_ENABLE
+int coHotplugRegister(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, size_t n) {
+    assert(co);
+    assert(nodeId > 0 && nodeId <= 127);
+    assert(cfg);
+    assert(n > 0);
+    co_hotplug_t *free = NULL;
+    for (size_t i = 0; i < CO_HOTPLUG_NODES; ++i) {
+        if (nodeId == co->hotplug[i].nodeId) {
+            free = &co->hotplug[i]; // already registered, replace
+            break;
+        } else if (NULL == free && 0 == co->hotplug[i].nodeId) {
+            free = &co->hotplug[i];
+        }
+    }
+    if (NULL == free) {
+        return -1; // no space left
+    }
+    *free = (co_hotplug_t){.cfg = cfg, .n = n, .nodeId = nodeId};
+    return 0;
+}
+
+static void hotplugBoot(co_t *co, uint8_t nodeId) {
+    assert(co);
+    for (size_t i = 0; i < CO_HOTPLUG_NODES; ++i) {
+        const co_hotplug_t *node = &co->hotplug[i];
+        if (nodeId != node->nodeId) {
+            continue;
+        }
+        // if node rebooted during its configuration, start over in same job
+        co_sdo_job_t *job = sdoAsyncFind(co, nodeId);
+        for (size_t j = 0; NULL == job && j < CO_SDO_ASYNC_JOBS; ++j) {
+            if (NULL == co->sdoJobs[j].cfg) {
+                job = &co->sdoJobs[j];
+            }
+        }
+        if (NULL == job || 0 != sdoAsyncStart(co, job, nodeId, node->cfg, node->n)) {
+            if (co->sdoDone) {
+                co->sdoDone(nodeId, -1); // can't reconfigure node
+            }
+            return;
+        }
+        job->hotplug = 1;
+        return;
+    }
+}
+#endif
+
+#ifdef CO_ROUTER_ENABLE
+int coRouteAdd(co_router_t *router, uint16_t from, uint16_t to) {
+    assert(router);
+    assert(from <= 0x7ff);
+    assert(to <= 0x7ff);
+    co_route_t *route = NULL;
+    for (size_t i = 0; i < router->n && NULL == route; ++i) {
+        if (from == router->routes[i].from) {
+            route = &router->routes[i]; // already routed, change it
+        }
+    }
+    if (NULL == route) {
+        if (CO_ROUTES <= router->n) {
+            return -1; // no space left
+        }
+        route = &router->routes[router->n++];
+    }
+    *route = (co_route_t){.from = from, .to = to};
+    router->filter[from >> 5] |= (uint32_t)1 << (from & 0x1f);
+    return 0;
+}
+
+int coRouteDel(co_router_t *router, uint16_t from) {
+    assert(router);
+    assert(from <= 0x7ff);
+    for (size_t i = 0; i < router->n; ++i) {
+        if (from == router->routes[i].from) {
+            router->routes[i] = router->routes[--router->n]; // keep routes packed
+            router->filter[from >> 5] &= ~((uint32_t)1 << (from & 0x1f));
+            return 0;
+        }
+    }
+    return -1; // no such route
+}
+
+static void routerForward(co_router_t *router, const co_msg_t *msg) {
+    assert(router);
+    assert(router->to && router->to->tx);
+    assert(msg);
+    uint16_t cobId = msg->cobId & 0x7ff;
+    if (0 == (router->filter[cobId >> 5] & ((uint32_t)1 << (cobId & 0x1f)))) {
+        return; // fast path, not routed
+    }
+    co_route_t *route = router->routes;
+    while (cobId != route->from) {
+        ++route; // filter guarantees there is a route
+    }
+    int ret;
+    if (route->to == route->from) {
+        ret = router->to->tx(msg); // send as it is
+    } else {
+        co_msg_t fwd = *msg;
+        fwd.cobId = route->to;
+        ret = router->to->tx(&fwd);
+    }
+    if (0 != ret) {
+        ++route->errors;
+        return;
+    }
+    ++route->forwarded;
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+    if (router->ns && 0 != msg->ts) {
+        latencyUpdate(&route->latency, router->ns() - msg->ts);
+    }
+#endif
+}
+#endif
+
+#ifdef CO_REPLAY_ENABLE
+int coLogNext(co_log_t *log, co_msg_t *msg, uint64_t *ts, uint8_t *master) {
+    assert(log);
+    assert(log->data || 0 == log->len);
+    assert(msg);
+    assert(ts);
+    assert(master);
+#ifdef CO_BLOG_ENABLE
+    if (0 == log->lines && 0 == log->pos && BLOG_HEADER <= log->len
+        && CO_BLOG_MAGIC == blogGet((const uint8_t *)log->data, 4)) {
+        log->binary = 1;
+    }
+    if (log->binary) {
+        uint8_t rtr;
+        int ret;
+        while (0 > (ret = blogDecode(log, msg, &rtr))) {
+            ++log->skipped; // rest of corrupt block is skipped
+        }
+        if (0 != ret) {
+            return 1; // end of log
+        }
+        log->line = ++log->lines;
+        *ts = log->ts;
+        *master = logIsMaster(msg, rtr);
+#ifdef CO_NODE_GUARDING_ENABLE
+        msg->rtr = rtr;
+#endif
+        msg->ts = log->ts;
+        return 0;
+    }
+#endif
+    while (log->pos < log->len) {
+        const char *p = log->data + log->pos;
+        const char *end = memchr(p, '\n', log->len - log->pos);
+        if (NULL == end) {
+            end = log->data + log->len; // last line without line feed
+        }
+        log->pos = (size_t)(end - log->data) + 1;
+        ++log->lines;
+        if (end > p && '\r' == end[-1]) {
+            --end;
+        }
+        if (0 == logParse(p, end, msg, ts, master)) {
+            log->line = log->lines;
+            log->framePos = (size_t)(p - log->data);
+            return 0;
+        }
+        ++log->skipped;
+    }
+    return 1; // end of log
+}
+
+void coLogSeek(co_log_t *log, size_t pos) {
+    assert(log);
+    assert(log->data || 0 == log->len);
+    assert(pos <= log->len);
+#ifdef CO_BLOG_ENABLE
+    if (BLOG_HEADER <= log->len && CO_BLOG_MAGIC == blogGet((const uint8_t *)log->data, 4)) {
+        log->binary = 1;
+        log->blockEnd = pos; // next read starts the block at pos
+    }
+#endif
+    log->pos = pos;
+}
+
+void coReplayInit(co_replay_t *replay, const char *data, size_t len, co_time_cb_t ms, uint32_t speed) {
+    assert(replay);
+    assert(data || 0 == len);
+    assert(NULL == ms || speed > 0);
+    *replay = (co_replay_t){
+        .rx = {.data = data, .len = len},
+        .tx = {.data = data, .len = len},
+        .ms = ms,
+        .speed = speed};
+}
+
+int coReplayRx(co_replay_t *replay, co_msg_t *msg) {
+    assert(replay);
+    assert(msg);
+    if (!replay->pending) {
+        if (0 != logNextOf(&replay->rx, &replay->next, &replay->nextTs, 0)) {
+            return 1; // end of log
+        }
+        replay->pending = 1;
+    }
+    if (replay->ms) {
+        uint32_t now = replay->ms();
+        if (!replay->started) {
+            replay->startMs = now;
+            replay->startTs = replay->nextTs;
+            replay->started = 1;
+        }
+        // due if the elapsed time, accelerated by speed, reached the recorded time
+        uint64_t elapsedNs = (uint64_t)(uint32_t)(now - replay->startMs) * 1000000 * replay->speed;
+        if (replay->nextTs > replay->startTs && replay->nextTs - replay->startTs > elapsedNs) {
+            return 1; // not yet due
+        }
+    }
+    *msg = replay->next;
+    replay->pending = 0;
+    return 0;
+}
+
+int coReplayTx(co_replay_t *replay, const co_msg_t *msg) {
+    assert(replay);
+    assert(msg);
+    co_msg_t expected;
+    uint64_t ts;
+    if (0 != logNextOf(&replay->tx, &expected, &ts, 1)) {
+        ++replay->unexpected;
+        return 0;
+    }
+    int equal = (expected.cobId == msg->cobId && expected.len == msg->len
+                 && 0 == memcmp(expected.data, msg->data, msg->len));
+#ifdef CO_NODE_GUARDING_ENABLE
+    equal = equal && (expected.rtr == msg->rtr);
+#endif
+    if (equal) {
+        ++replay->matched;
+    } else {
+        if (0 == replay->mismatched) {
+            replay->firstMismatch = replay->tx.line;
+        }
+        ++replay->mismatched;
+    }
+    return 0;
+}
+
+uint32_t coReplayFinish(co_replay_t *replay) {
+    assert(replay);
+    co_msg_t msg;
+    uint64_t ts;
+    while (0 == logNextOf(&replay->tx, &msg, &ts, 1)) {
+        ++replay->missing;
+    }
+    return replay->mismatched + replay->unexpected + replay->missing;
+}
+
+static int logParse(const char *p, const char *end, co_msg_t *msg, uint64_t *ts, uint8_t *master) {
+    assert(p && end);
+    assert(msg);
+    assert(ts);
+    assert(master);
+    *msg = (co_msg_t){0};
+    uint32_t value;
+    uint8_t rtr = 0;
+    p = logSpace(p, end);
+    if (p < end && '(' == *p) {
+        // candump: (1436509052.249713) can0 123#DEADBEEF or 123#R
+        ++p;
+        if (0 != logTime(&p, end, ts) || p >= end || ')' != *p++) {
+            return -1;
+        }
+        p = logSpace(p, end);
+        while (p < end && ' ' != *p && '\t' != *p) {
+            ++p; // interface name
+        }
+        p = logSpace(p, end);
+        if (3 != logHex(&p, end, &value) || p >= end || '#' != *p++) {
+            return -1; // no standard frame
+        }
+        msg->cobId = value;
+        if (p < end && 'R' == *p) {
+            rtr = 1;
+            ++p;
+            if (p < end && 1 == logHex(&p, end, &value) && 8 >= value) {
+                msg->len = value; // length of remote frame
+            }
+        } else {
+            for (; p + 1 < end && '#' != *p && 8 > msg->len; ++msg->len) {
+                const char *digits = p;
+                if (2 != logHex(&digits, p + 2, &value)) {
+                    return -1;
+                }
+                msg->data[msg->len] = value;
+                p += 2;
+                if (p < end && '.' == *p) {
+                    ++p; // optional byte separator
+                }
+            }
+        }
+        if (logSpace(p, end) != end) {
+            return -1; // e.g. FD frame
+        }
+        *master = logIsMaster(msg, rtr);
+    } else {
+        // ASC: 0.012345 1  123             Rx   d 8 01 02 03 04 05 06 07 08 ...
+        if (0 != logTime(&p, end, ts)) {
+            return -1;
+        }
+        p = logSpace(p, end);
+        if (0 == logHex(&p, end, &value)) {
+            return -1; // no channel
+        }
+        p = logSpace(p, end);
+        if (0 == logHex(&p, end, &value) || 0x7ff < value || (p < end && ' ' != *p && '\t' != *p)) {
+            return -1; // e.g. error frame, extended frame or event
+        }
+        msg->cobId = value;
+        p = logSpace(p, end);
+        if (p + 2 > end || 'x' != (p[1] | 0x20) || ('R' != p[0] && 'T' != p[0])) {
+            return -1;
+        }
+        *master = ('T' == p[0]);
+        p = logSpace(p + 2, end);
+        if (p < end && 'r' == *p) {
+            rtr = 1;
+            p = logSpace(p + 1, end);
+            if (1 == logHex(&p, end, &value) && 8 >= value) {
+                msg->len = value;
+            }
+        } else if (p < end && 'd' == *p) {
+            p = logSpace(p + 1, end);
+            if (1 != logHex(&p, end, &value) || 8 < value) {
+                return -1;
+            }
+            msg->len = value;
+            for (size_t i = 0; i < msg->len; ++i) {
+                p = logSpace(p, end);
+                if (2 != logHex(&p, end, &value)) {
+                    return -1;
+                }
+                msg->data[i] = value;
+            }
+        } else {
+            return -1;
+        }
+    }
+#ifdef CO_NODE_GUARDING_ENABLE
+    msg->rtr = rtr;
+#else
+    if (rtr) {
+        return -1; // remote frames can't be represented
+    }
+#endif
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+    msg->ts = *ts;
+#endif
+    return 0;
+}
+
+static size_t logHex(const char **p, const char *end, uint32_t *value) {
+    assert(p && *p);
+    assert(end);
+    assert(value);
+    const char *s = *p;
+    uint32_t number = 0;
+    size_t n = 0;
+    for (; s < end && 8 > n; ++s, ++n) {
+        char c = *s;
+        if ('0' <= c && '9' >= c) {
+            number = (number << 4) | (c - '0');
+        } else if ('a' <= (c | 0x20) && 'f' >= (c | 0x20)) {
+            number = (number << 4) | ((c | 0x20) - 'a' + 10);
+        } else {
+            break;
+        }
+    }
+    *p = s;
+    *value = number;
+    return n;
+}
+
+static int logTime(const char **p, const char *end, uint64_t *ns) {
+    assert(p && *p);
+    assert(end);
+    assert(ns);
+    const char *s = *p;
+    uint64_t sec = 0;
+    uint64_t frac = 0;
+    uint32_t scale = 1000000000;
+    const char *start = s;
+    for (; s < end && '0' <= *s && '9' >= *s; ++s) {
+        sec = sec * 10 + (*s - '0');
+    }
+    if (s == start || s >= end || '.' != *s) {
+        return -1;
+    }
+    for (++s; s < end && '0' <= *s && '9' >= *s; ++s) {
+        if (1 < scale) {
+            scale /= 10;
+            frac += (uint64_t)(*s - '0') * scale;
+        }
+    }
+    *p = s;
+    *ns = sec * 1000000000 + frac;
+    return 0;
+}
+
+static inline const char *logSpace(const char *p, const char *end) {
+    while (p < end && (' ' == *p || '\t' == *p)) {
+        ++p;
+    }
+    return p;
+}
+
+static int logIsMaster(const co_msg_t *msg, uint8_t rtr) {
+    assert(msg);
+    co_cob_id_t cobId = getCOBIDType(msg);
+    uint8_t nodeId = getNodeId(msg);
+    if (COB_ID_RPDO1 <= cobId && COB_ID_TSDO > cobId && 0 == (cobId & 0x080)) {
+        return 0 < nodeId; // RxPDO 1 - 4
+    }
+    switch (cobId) {
+    case COB_ID_NMT:
+    case COB_ID_TIME:
+    case COB_ID_RSDO:
+        return 1;
+    case COB_ID_SYNC: // same as EMCY, SYNC has no node-id
+        return 0 == nodeId;
+    case COB_ID_HRTB: // node guarding request
+        return rtr;
+    default:
+        return 0;
+    }
+}
+
+static int logNextOf(co_log_t *log, co_msg_t *msg, uint64_t *ts, uint8_t master) {
+    assert(log);
+    uint8_t isMaster;
+    do {
+        if (0 != coLogNext(log, msg, ts, &isMaster)) {
+            return 1; // end of log
+        }
+    } while (master != isMaster);
+    return 0;
+}
+#endif
+
+#ifdef CO_BLOG_ENABLE
+int coBlogRecord(co_blog_t *blog, const co_msg_t *msg) {
+    assert(blog);
+    assert(msg);
+    if (0 != coRingTx(&blog->ring, msg)) {
+        ++blog->dropped;
+        return -1;
+    }
+    return 0;
+}
+
+int coBlogWork(co_blog_t *blog) {
+    assert(blog);
+    assert(blog->write);
+    co_msg_t msg;
+    int count = 0;
+    while (0 == coRingRx(&blog->ring, &msg)) {
+        if (0 != blogEncode(blog, &msg)) {
+            return -1;
+        }
+        ++count;
+    }
+    return count;
+}
+
+int coBlogFlush(co_blog_t *blog) {
+    assert(blog);
+    assert(blog->write);
+    if (0 == blog->used) {
+        return 0; // nothing to store
+    }
+    blogPut(blog->block + 4, blog->used, 4);
+    blogPut(blog->block + 8, blog->frames, 4);
+    int ret = blog->write(blog->block, blog->used);
+    if (0 != ret) {
+        ++blog->errors;
+    }
+    blog->used = 0; // start a new block, even on error
+    return ret;
+}
+
+size_t coBlogIndex(const void *data, size_t len, size_t *offsets, uint64_t *ts, size_t n) {
+    assert(data || 0 == len);
+    assert((offsets && ts) || 0 == n);
+    const uint8_t *p = data;
+    size_t count = 0;
+    for (size_t pos = 0; pos + BLOG_HEADER <= len; ++count) {
+        size_t size = blogGet(p + pos + 4, 4);
+        if (CO_BLOG_MAGIC != blogGet(p + pos, 4) || BLOG_HEADER > size || len - pos < size) {
+            break; // not a binary log or truncated
+        }
+        if (count < n) {
+            offsets[count] = pos;
+            ts[count] = blogGet(p + pos + 16, 8);
+        }
+        pos += size;
+    }
+    return count;
+}
+
+static int blogEncode(co_blog_t *blog, const co_msg_t *msg) {
+    assert(blog);
+    assert(msg);
+    if (CO_BLOG_BLOCK < blog->used + BLOG_FRAME && 0 != coBlogFlush(blog)) {
+        return -1; // block is full but could not be stored
+    }
+    uint64_t ts = msg->ts / CO_BLOG_RES_NS;
+    if (0 == blog->used) {
+        // new block, everything is relative to its header
+        blogPut(blog->block, CO_BLOG_MAGIC, 4);
+        blogPut(blog->block + 12, CO_BLOG_RES_NS, 4);
+        blogPut(blog->block + 16, ts * CO_BLOG_RES_NS, 8);
+        blog->used = BLOG_HEADER;
+        blog->frames = 0;
+        blog->ts = ts;
+        blog->dictLen = 0;
+    }
+    uint8_t *p = blog->block + blog->used;
+    // timestamp delta, zigzag and varint encoded, frames may be slightly out of order
+    int64_t delta = (int64_t)(ts - blog->ts);
+    uint64_t zigzag = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+    blog->ts = ts;
+    do {
+        *p++ = (zigzag & 0x7f) | ((0x7f < zigzag) ? 0x80 : 0x00);
+        zigzag >>= 7;
+    } while (0 != zigzag);
+    // COB-ID from dictionary or literal
+    uint16_t cobId = msg->cobId & 0x7ff;
+    uint8_t code = 127;
+    for (uint8_t i = 0; i < blog->dictLen; ++i) {
+        if (cobId == blog->dict[i]) {
+            code = i;
+            break;
+        }
+    }
+    *p++ = code;
+    if (127 == code) {
+        blogPut(p, cobId, 2);
+        p += 2;
+        if (127 > blog->dictLen) {
+            code = blog->dictLen++;
+            blog->dict[code] = cobId;
+            blog->prevLen[code] = 0xff; // no previous payload
+        }
+    }
+    // payload, XORed against the previous one of this COB-ID if possible
+    uint8_t rtr = 0;
+#ifdef CO_NODE_GUARDING_ENABLE
+    rtr = msg->rtr;
+#endif
+    uint8_t len = (8 < msg->len) ? 8 : msg->len;
+    uint8_t diffed = (127 > code && len == blog->prevLen[code] && !rtr);
+    *p++ = len | (rtr << 4) | (diffed << 5);
+    if (diffed) {
+        uint8_t *mask = p++;
+        *mask = 0;
+        for (uint8_t i = 0; i < len; ++i) {
+            uint8_t diff = msg->data[i] ^ blog->prev[code][i];
+            if (0 != diff) {
+                *mask |= 1 << i;
+                *p++ = diff;
+            }
+        }
+    } else if (!rtr) {
+        memcpy(p, msg->data, len);
+        p += len;
+    }
+    if (127 > code && !rtr) {
+        memcpy(blog->prev[code], msg->data, len);
+        blog->prevLen[code] = len;
+    }
+    blog->used = (size_t)(p - blog->block);
+    ++blog->frames;
+    return 0;
+}
+
+static int blogDecode(co_log_t *log, co_msg_t *msg, uint8_t *rtr) {
+    assert(log);
+    assert(msg);
+    assert(rtr);
+    const uint8_t *data = (const uint8_t *)log->data;
+    if (log->pos >= log->blockEnd) {
+        // start of next block
+        size_t pos = log->blockEnd;
+        if (pos + BLOG_HEADER > log->len) {
+            return 1; // end of log
+        }
+        size_t size = blogGet(data + pos + 4, 4);
+        if (CO_BLOG_MAGIC != blogGet(data + pos, 4) || BLOG_HEADER > size || log->len - pos < size) {
+            log->pos = log->blockEnd = log->len;
+            return -1; // corrupt or truncated, nothing more to read
+        }
+        log->blockEnd = pos + size;
+        log->framePos = pos; // frames are only readable from the start of their block
+        log->res = blogGet(data + pos + 12, 4);
+        log->ts = blogGet(data + pos + 16, 8);
+        log->dictLen = 0;
+        log->pos = pos + BLOG_HEADER;
+        if (log->pos >= log->blockEnd) {
+            return -1; // empty block
+        }
+    }
+    const uint8_t *p = data + log->pos;
+    const uint8_t *end = data + log->blockEnd;
+    *msg = (co_msg_t){0};
+    log->pos = log->blockEnd; // skip rest of block on any error below
+    // timestamp delta
+    uint64_t zigzag = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        if (p >= end || 63 < shift) {
+            return -1;
+        }
+        zigzag |= (uint64_t)(*p & 0x7f) << shift;
+        if (0 == (*p++ & 0x80)) {
+            break;
+        }
+    }
+    int64_t delta = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+    log->ts += delta * log->res;
+    // COB-ID
+    if (p >= end) {
+        return -1;
+    }
+    uint8_t code = *p++;
+    if (127 == code) {
+        if (p + 2 > end) {
+            return -1;
+        }
+        msg->cobId = blogGet(p, 2);
+        p += 2;
+        if (127 > log->dictLen) {
+            code = log->dictLen++;
+            log->dict[code] = msg->cobId;
+            log->prevLen[code] = 0xff; // no previous payload
+        }
+    } else if (code < log->dictLen) {
+        msg->cobId = log->dict[code];
+    } else {
+        return -1;
+    }
+    // payload
+    if (p >= end) {
+        return -1;
+    }
+    uint8_t flags = *p++;
+    msg->len = flags & 0x0f;
+    *rtr = (flags >> 4) & 0x01;
+    if (8 < msg->len) {
+        return -1;
+    }
+    if (flags & 0x20) {
+        if (127 <= code || msg->len != log->prevLen[code] || p >= end) {
+            return -1;
+        }
+        uint8_t mask = *p++;
+        for (uint8_t i = 0; i < msg->len; ++i) {
+            msg->data[i] = log->prev[code][i];
+            if (mask & (1 << i)) {
+                if (p >= end) {
+                    return -1;
+                }
+                msg->data[i] ^= *p++;
+            }
+        }
+    } else if (!*rtr) {
+        if (p + msg->len > end) {
+            return -1;
+        }
+        memcpy(msg->data, p, msg->len);
+        p += msg->len;
+    }
+    if (127 > code && !*rtr) {
+        memcpy(log->prev[code], msg->data, msg->len);
+        log->prevLen[code] = msg->len;
+    }
+    log->pos = (size_t)(p - data);
+    return 0;
+}
+
+static uint64_t blogGet(const uint8_t *p, size_t n) {
+    assert(p);
+    uint64_t value = 0;
+    for (size_t i = n; 0 < i; --i) {
+        value = (value << 8) | p[i - 1];
+    }
+    return value;
+}
+
+static void blogPut(uint8_t *p, uint64_t value, size_t n) {
+    assert(p);
+    for (size_t i = 0; i < n; ++i) {
+        p[i] = (value >> (8 * i)) & 0xff;
+    }
+}
+#endif
+
+#ifdef CO_FAULT_ENABLE
+void coFaultInit(co_fault_t *fault) {
+    assert(fault);
+    assert(fault->ms);
+    assert(fault->rules || 0 == fault->n);
+    fault->state = (0 == fault->seed) ? 0x2545f491 : fault->seed; // xorshift state must not be zero
+    fault->start = fault->ms();
+    fault->busOff = 0;
+    for (size_t i = 0; i < CO_FAULT_DELAYED; ++i) {
+        fault->delayed[i].dir = 0;
+    }
+    for (size_t i = 0; i < fault->n; ++i) {
+        fault->rules[i].hits = 0;
+    }
+}
+
+int coFaultRx(co_fault_t *fault, co_msg_t *msg) {
+    assert(fault);
+    assert(fault->rx);
+    assert(fault->ms);
+    assert(msg);
+    faultPumpTx(fault);
+    // held back frames first, oldest due one
+    uint32_t now = fault->ms();
+    co_fault_delayed_t *oldest = NULL;
+    for (size_t i = 0; i < CO_FAULT_DELAYED; ++i) {
+        co_fault_delayed_t *d = &fault->delayed[i];
+        if (CO_FAULT_RX == d->dir && 0 <= (int32_t)(now - d->due)
+            && (NULL == oldest || 0 < (int32_t)(oldest->due - d->due))) {
+            oldest = d;
+        }
+    }
+    if (NULL != oldest) {
+        *msg = oldest->msg;
+        oldest->dir = 0;
+        return 0;
+    }
+    int ret;
+    while (0 == (ret = fault->rx(msg))) {
+        if (fault->busOff) {
+            continue; // controller doesn't take part in communication
+        }
+        co_fault_rule_t *rule = faultMatch(fault, msg, CO_FAULT_RX);
+        if (NULL == rule) {
+            return 0;
+        }
+        switch (rule->type) {
+        case CO_FAULT_DROP:
+            continue;
+        case CO_FAULT_DELAY:
+            if (0 != faultHold(fault, msg, CO_FAULT_RX, rule->param)) {
+                return 0; // no space left, pass on undelayed
+            }
+            continue;
+        case CO_FAULT_DUP:
+            faultHold(fault, msg, CO_FAULT_RX, 0); // copy is returned with next call
+            return 0;
+        case CO_FAULT_CORRUPT:
+        default: // bus-off is only injected on tx
+            return 0;
+        }
+    }
+    return ret;
+}
+
+int coFaultTx(co_fault_t *fault, const co_msg_t *msg) {
+    assert(fault);
+    assert(fault->tx);
+    assert(msg);
+    faultPumpTx(fault);
+    if (fault->busOff) {
+        return -1;
+    }
+    co_msg_t copy = *msg;
+    co_fault_rule_t *rule = faultMatch(fault, &copy, CO_FAULT_TX);
+    if (NULL == rule) {
+        return fault->tx(msg);
+    }
+    switch (rule->type) {
+    case CO_FAULT_DROP:
+        return 0; // sent successfully, but lost on the bus
+    case CO_FAULT_DELAY:
+        if (0 == faultHold(fault, msg, CO_FAULT_TX, rule->param)) {
+            return 0;
+        }
+        return fault->tx(msg); // no space left, send undelayed
+    case CO_FAULT_DUP:
+        if (0 != fault->tx(msg)) {
+            return -1;
+        }
+        return fault->tx(msg);
+    case CO_FAULT_CORRUPT:
+        return fault->tx(&copy);
+    case CO_FAULT_BUS_OFF:
+    default:
+        fault->busOff = 1;
+        return -1;
+    }
+}
+
+int coFaultStatus(co_fault_t *fault, co_bus_status_t *status) {
+    assert(fault);
+    assert(status);
+    if (fault->status) {
+        if (0 != fault->status(status)) {
+            return -1;
+        }
+    } else {
+        *status = (co_bus_status_t){.state = CO_BUS_ACTIVE};
+    }
+    if (fault->busOff) {
+        status->state = CO_BUS_OFF;
+        status->tec = 255;
+    }
+    return 0;
+}
+
+int coFaultRestart(co_fault_t *fault) {
+    assert(fault);
+    fault->busOff = 0;
+    // frames held back are lost with the restart
+    for (size_t i = 0; i < CO_FAULT_DELAYED; ++i) {
+        fault->delayed[i].dir = 0;
+    }
+    return fault->restart ? fault->restart() : 0;
+}
+
+static uint32_t faultRandom(co_fault_t *fault) {
+    assert(fault);
+    uint32_t x = fault->state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    fault->state = x;
+    return x;
+}
+
+static co_fault_rule_t *faultMatch(co_fault_t *fault, co_msg_t *msg, uint8_t dir) {
+    assert(fault);
+    assert(fault->ms);
+    assert(msg);
+    uint32_t now = fault->ms();
+    uint32_t elapsed = now - fault->start;
+    for (size_t i = 0; i < fault->n; ++i) {
+        co_fault_rule_t *rule = &fault->rules[i];
+        if (0 == (dir & rule->dir)
+            || (msg->cobId & rule->mask) != (rule->cobId & rule->mask)
+            || elapsed < rule->from
+            || (0 != rule->to && elapsed >= rule->to)
+            || (CO_FAULT_BUS_OFF == rule->type && CO_FAULT_TX != dir)) {
+            continue; // rule doesn't apply
+        }
+        if (CO_FAULT_ALWAYS > rule->chance && (faultRandom(fault) >> 16) >= rule->chance) {
+            continue; // lucky frame
+        }
+        if (CO_FAULT_CORRUPT == rule->type) {
+            uint32_t bit = faultRandom(fault) % (11 + 8 * msg->len);
+            if (11 > bit) {
+                msg->cobId ^= 1 << bit;
+            } else {
+                msg->data[(bit - 11) >> 3] ^= 1 << ((bit - 11) & 0x07);
+            }
+        }
+        if (0 == rule->hits) {
+            rule->firstHit = now;
+        }
+        rule->lastHit = now;
+        ++rule->hits;
+        return rule;
+    }
+    return NULL;
+}
+
+static int faultHold(co_fault_t *fault, const co_msg_t *msg, uint8_t dir, uint32_t delay) {
+    assert(fault);
+    assert(fault->ms);
+    assert(msg);
+    for (size_t i = 0; i < CO_FAULT_DELAYED; ++i) {
+        co_fault_delayed_t *d = &fault->delayed[i];
+        if (0 == d->dir) {
+            *d = (co_fault_delayed_t){.msg = *msg, .due = fault->ms() + delay, .dir = dir};
+            return 0;
+        }
+    }
+    return -1; // no space left
+}
+
+static void faultPumpTx(co_fault_t *fault) {
+    assert(fault);
+    assert(fault->ms);
+    uint32_t now = fault->ms();
+    for (size_t i = 0; i < CO_FAULT_DELAYED; ++i) {
+        co_fault_delayed_t *d = &fault->delayed[i];
+        if (CO_FAULT_TX == d->dir && 0 <= (int32_t)(now - d->due)) {
+            d->dir = 0;
+            if (!fault->busOff) {
+                fault->tx(&d->msg); // error can't be reported anymore
+            }
+        }
+    }
+}
+#endif
+
+#ifdef CO_RTA_ENABLE
+int coRTA(co_rta_frame_t *frames, size_t n, uint32_t bitrate, uint32_t syncPeriodUs, uint32_t acyclicUs) {
+    assert(frames || 0 == n);
+    if (0 == bitrate || 0 == syncPeriodUs || acyclicUs >= syncPeriodUs) {
+        return -1;
+    }
+    uint64_t bitNs = (1000000000ull + bitrate - 1) / bitrate;
+    uint64_t syncNs = (uint64_t)syncPeriodUs * 1000;
+    // SYNC and acyclic traffic are modelled as one burst with every SYNC
+#ifdef CO_SYNC_COUNTER_ENABLE
+    uint64_t cyclicNs = rtaFrameNs(1, bitNs) + (uint64_t)acyclicUs * 1000;
+#else
+    uint64_t cyclicNs = rtaFrameNs(0, bitNs) + (uint64_t)acyclicUs * 1000;
+#endif
+    // acyclic traffic may be of lower priority too, e.g. SDO
+    uint64_t blockingNs = (0 < acyclicUs) ? rtaFrameNs(8, bitNs) : 0;
+    // utilization in 1/2^32, the busy period is unbounded for 100% or more
+    uint64_t utilization = (cyclicNs << 32) / syncNs;
+    for (size_t i = 0; i < n; ++i) {
+        rta_task_t task = rtaTask(&frames[i], syncNs, bitNs);
+        utilization += (task.c << 32) / task.t;
+    }
+    int misses = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (((uint64_t)1 << 32) <= utilization) {
+            frames[i].responseUs = UINT32_MAX;
+            ++misses;
+            continue;
+        }
+        uint64_t r = rtaResponse(frames, n, i, cyclicNs, blockingNs, syncNs, bitNs);
+        frames[i].responseUs = (r / 1000 < UINT32_MAX) ? (r + 999) / 1000 : UINT32_MAX;
+        if (r > rtaTask(&frames[i], syncNs, bitNs).d) {
+            ++misses;
+        }
+    }
+    return misses;
+}
+
+uint32_t coRTAMinSyncPeriod(co_rta_frame_t *frames, size_t n, uint32_t bitrate, uint32_t acyclicUs) {
+    assert(frames || 0 == n);
+    uint32_t lo = acyclicUs; // infeasible
+    uint32_t hi = 1000000;   // one second
+    if (0 != coRTA(frames, n, bitrate, hi, acyclicUs)) {
+        return 0; // not even feasible with one second
+    }
+    // longer SYNC periods only lower interference, search for the border
+    while (lo + 1 < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (0 == coRTA(frames, n, bitrate, mid, acyclicUs)) {
+            hi = mid;
+        } else {
+            lo = mid;
+        }
+    }
+    coRTA(frames, n, bitrate, hi, acyclicUs); // leave response times of the result
+    return hi;
+}
+
+static rta_task_t rtaTask(const co_rta_frame_t *frame, uint64_t syncNs, uint64_t bitNs) {
+    assert(frame);
+    assert(frame->len <= 8);
+    uint64_t t = (0 == frame->periodUs) ? syncNs : (uint64_t)frame->periodUs * 1000;
+    return (rta_task_t){
+        .cobId = frame->cobId,
+        .c = rtaFrameNs(frame->len, bitNs),
+        .t = t,
+        .j = (uint64_t)frame->jitterUs * 1000,
+        .d = (0 == frame->deadlineUs) ? t : (uint64_t)frame->deadlineUs * 1000};
+}
+
+static inline uint64_t rtaFrameNs(uint8_t len, uint64_t bitNs) {
+    // 34 bits subject to stuffing (SOF, id, control, CRC) plus 8 per data byte,
+    // one stuff bit every 4 bits in the worst case, 13 bits without stuffing
+    // (CRC delimiter, ACK, EOF, interframe space)
+    uint64_t g = 34 + 8 * (uint64_t)len;
+    return (g + 13 + (g - 1) / 4) * bitNs;
+}
+
+static uint64_t rtaResponse(const co_rta_frame_t *frames, size_t n, size_t m, uint64_t cyclicNs,
+                            uint64_t blockingNs, uint64_t syncNs, uint64_t bitNs) {
+    assert(frames);
+    assert(m < n);
+    rta_task_t f = rtaTask(&frames[m], syncNs, bitNs);
+    // blocking by the longest frame of lower priority
+    uint64_t b = blockingNs;
+    for (size_t k = 0; k < n; ++k) {
+        rta_task_t other = rtaTask(&frames[k], syncNs, bitNs);
+        if (k != m && other.cobId > f.cobId && other.c > b) {
+            b = other.c;
+        }
+    }
+    // length of the busy period of priority m
+    uint64_t t = f.c;
+    for (uint64_t last = 0; t != last;) {
+        last = t;
+        t = b + (last + syncNs - 1) / syncNs * cyclicNs;
+        for (size_t k = 0; k < n; ++k) {
+            rta_task_t other = rtaTask(&frames[k], syncNs, bitNs);
+            if (k == m || other.cobId <= f.cobId) {
+                t += (last + other.j + other.t - 1) / other.t * other.c;
+            }
+        }
+    }
+    // every instance in the busy period may be the worst one
+    uint64_t instances = (t + f.j + f.t - 1) / f.t;
+    uint64_t r = 0;
+    for (uint64_t q = 0; q < instances; ++q) {
+        uint64_t w = b + q * f.c;
+        for (uint64_t last = 0; w != last;) {
+            last = w;
+            w = b + q * f.c + (last + bitNs + syncNs - 1) / syncNs * cyclicNs;
+            for (size_t k = 0; k < n; ++k) {
+                rta_task_t other = rtaTask(&frames[k], syncNs, bitNs);
+                if (k != m && other.cobId <= f.cobId) {
+                    w += (last + other.j + bitNs + other.t - 1) / other.t * other.c;
+                }
+            }
+        }
+        uint64_t rq = f.j + w - q * f.t + f.c;
+        if (rq > r) {
+            r = rq;
+        }
+    }
+    return r;
+}
+#endif
+
+#ifdef CO_REDUNDANT_ENABLE
+void coRedundantInit(co_redundant_t *red) {
+    assert(red);
+    assert(red->ms);
+    for (size_t b = 0; b < 2; ++b) {
+        co_redundant_bus_t *bus = &red->bus[b];
+        assert(bus->rx && bus->tx);
+        bus->received = 0;
+        bus->first = 0;
+        bus->lost = 0;
+        bus->late = 0;
+        bus->rxErrors = 0;
+        bus->txErrors = 0;
+        bus->restarts = 0;
+        bus->lastRx = red->ms();
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+        bus->lag = (co_latency_t){0};
+#endif
+    }
+    red->next = 0;
+    for (size_t i = 0; i < CO_REDUNDANT_PENDING; ++i) {
+        red->pending[i].bus = 0;
+        red->overdue[i].bus = 0;
+    }
+}
+
+int coRedundantRx(co_redundant_t *red, co_msg_t *msg) {
+    assert(red);
+    assert(red->ms);
+    assert(msg);
+    uint32_t now = red->ms();
+    redundantExpire(red, now);
+    uint8_t empty = 0;  // bitmap of buses without data
+    uint8_t failed = 0; // bitmap of buses with errors
+    while (0x3 != empty) {
+        // alternate between buses so neither one waits for the other
+        uint8_t b = red->next;
+        if (empty & (1 << b)) {
+            b ^= 1;
+        }
+        red->next = b ^ 1;
+        co_redundant_bus_t *bus = &red->bus[b];
+        int ret = bus->rx(msg);
+        if (0 != ret) {
+            if (0 > ret) {
+                ++bus->rxErrors;
+                failed |= 1 << b;
+            }
+            empty |= 1 << b;
+            continue;
+        }
+        ++bus->received;
+        bus->lastRx = now;
+        if (0 == redundantMerge(red, msg, b, now)) {
+            ++bus->first;
+            return 0;
+        }
+    }
+    return (0x3 == failed) ? -1 : 1;
+}
+
+int coRedundantTx(co_redundant_t *red, const co_msg_t *msg) {
+    assert(red);
+    assert(msg);
+    int sent = 0;
+    for (size_t b = 0; b < 2; ++b) {
+        co_redundant_bus_t *bus = &red->bus[b];
+        assert(bus->tx);
+        if (0 == bus->tx(msg)) {
+            ++sent;
+        } else {
+            ++bus->txErrors;
+        }
+    }
+    return (0 < sent) ? 0 : -1;
+}
+
+int coRedundantStatus(co_redundant_t *red, co_bus_status_t *status) {
+    assert(red);
+    assert(status);
+    co_bus_status_t s[2];
+    int ok[2];
+    for (size_t b = 0; b < 2; ++b) {
+        co_redundant_bus_t *bus = &red->bus[b];
+        if (bus->status) {
+            ok[b] = (0 == bus->status(&s[b]));
+        } else {
+            s[b] = (co_bus_status_t){.state = CO_BUS_ACTIVE};
+            ok[b] = 1;
+        }
+    }
+    if (!ok[0] && !ok[1]) {
+        return -1;
+    }
+    // recover a single bus here, coSimple needs no resync as the other one worked
+    for (size_t b = 0; b < 2; ++b) {
+        co_redundant_bus_t *bus = &red->bus[b];
+        if (ok[b] && CO_BUS_OFF == s[b].state && ok[b ^ 1] && CO_BUS_OFF != s[b ^ 1].state
+            && bus->restart && 0 == bus->restart()) {
+            ++bus->restarts;
+        }
+    }
+    size_t best = ok[0] ? 0 : 1;
+    if (ok[0] && ok[1]
+        && (s[1].state < s[0].state || (s[1].state == s[0].state && s[1].tec < s[0].tec))) {
+        best = 1;
+    }
+    *status = s[best];
+    return 0;
+}
+
+int coRedundantRestart(co_redundant_t *red) {
+    assert(red);
+    int restarted = 0;
+    for (size_t b = 0; b < 2; ++b) {
+        co_redundant_bus_t *bus = &red->bus[b];
+        if (NULL == bus->restart || 0 == bus->restart()) {
+            ++restarted;
+        }
+    }
+    // frames awaiting copies are outdated by the time the buses are back
+    for (size_t i = 0; i < CO_REDUNDANT_PENDING; ++i) {
+        red->pending[i].bus = 0;
+    }
+    return (0 < restarted) ? 0 : -1;
+}
+
+static int redundantMerge(co_redundant_t *red, const co_msg_t *msg, uint8_t b, uint32_t now) {
+    assert(red);
+    assert(msg);
+    assert(b < 2);
+    // the oldest matching frame of the other bus is the copy, keeps the order
+    // of frames with equal content, e.g. unchanged PDOs
+    co_redundant_pending_t *copy = NULL;
+    co_redundant_pending_t *unused = NULL;
+    co_redundant_pending_t *oldest = NULL;
+    for (size_t i = 0; i < CO_REDUNDANT_PENDING; ++i) {
+        co_redundant_pending_t *p = &red->pending[i];
+        if (0 == p->bus) {
+            unused = p;
+            continue;
+        }
+        if (NULL == oldest || 0 < (int32_t)(oldest->time - p->time)) {
+            oldest = p;
+        }
+        if (b + 1 == p->bus || msg->cobId != p->msg.cobId || msg->len != p->msg.len
+            || 0 != memcmp(msg->data, p->msg.data, msg->len)) {
+            continue;
+        }
+        if (NULL == copy || 0 < (int32_t)(copy->time - p->time)) {
+            copy = p;
+        }
+    }
+    if (NULL != copy) {
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+        if (0 != msg->ts && 0 != copy->msg.ts) {
+            latencyUpdate(&red->bus[b].lag, (msg->ts > copy->msg.ts) ? msg->ts - copy->msg.ts : 0);
+        }
+#endif
+        copy->bus = 0;
+        return 1;
+    }
+    for (size_t i = 0; i < CO_REDUNDANT_PENDING; ++i) {
+        co_redundant_pending_t *p = &red->overdue[i];
+        if (0 == p->bus || b + 1 == p->bus || msg->cobId != p->msg.cobId || msg->len != p->msg.len
+            || 0 != memcmp(msg->data, p->msg.data, msg->len)) {
+            continue;
+        }
+        if (NULL == copy || 0 < (int32_t)(copy->time - p->time)) {
+            copy = p;
+        }
+    }
+    if (NULL != copy) {
+        // late copy, was already counted as lost
+        --red->bus[b].lost;
+        ++red->bus[b].late;
+        copy->bus = 0;
+        return 1;
+    }
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+    latencyUpdate(&red->bus[b].lag, 0);
+#endif
+    if (NULL == unused) {
+        // no space left, give up on the oldest copy
+        ++red->bus[(oldest->bus - 1) ^ 1].lost;
+        unused = oldest;
+    }
+    unused->msg = *msg;
+    unused->time = now;
+    unused->bus = b + 1;
+    return 0;
+}
+
+static void redundantExpire(co_redundant_t *red, uint32_t now) {
+    assert(red);
+    for (size_t i = 0; i < CO_REDUNDANT_PENDING; ++i) {
+        co_redundant_pending_t *p = &red->overdue[i];
+        if (0 != p->bus && 2 * CO_REDUNDANT_WINDOW_MS <= now - p->time) {
+            p->bus = 0; // too late even for a late copy
+        }
+    }
+    for (size_t i = 0; i < CO_REDUNDANT_PENDING; ++i) {
+        co_redundant_pending_t *p = &red->pending[i];
+        if (0 == p->bus || CO_REDUNDANT_WINDOW_MS > now - p->time) {
+            continue;
+        }
+        ++red->bus[(p->bus - 1) ^ 1].lost; // copy didn't arrive on the other bus in time
+        // keep it as overdue, replacing the oldest one if there is no space left
+        co_redundant_pending_t *slot = NULL;
+        for (size_t j = 0; j < CO_REDUNDANT_PENDING && (NULL == slot || 0 != slot->bus); ++j) {
+            co_redundant_pending_t *o = &red->overdue[j];
+            if (NULL == slot || 0 == o->bus || 0 < (int32_t)(slot->time - o->time)) {
+                slot = o;
+            }
+        }
+        *slot = *p;
+        p->bus = 0;
+    }
+}
+#endif
+
+#ifdef CO_STANDBY_ENABLE
+#define SNAPSHOT_HEADER (10) //<! magic, layout, features and image size
+
+// sections of runtime state in a snapshot, 0 if not part of this build
+#ifdef CO_SYNC_COUNTER_ENABLE
+#define SNAPSHOT_SYNC (0x01) //<! SYNC counter
+#else
+#define SNAPSHOT_SYNC (0)
+#endif
+#ifdef CO_NMT_TABLE_ENABLE
+#define SNAPSHOT_NMT (0x02) //<! NMT node table
+#else
+#define SNAPSHOT_NMT (0)
+#endif
+#ifdef CO_HEARTBEAT_ENABLE
+#define SNAPSHOT_HB (0x04) //<! heartbeat producer
+#else
+#define SNAPSHOT_HB (0)
+#endif
+#ifdef CO_NODE_GUARDING_ENABLE
+#define SNAPSHOT_GUARD (0x08) //<! guarded nodes
+#else
+#define SNAPSHOT_GUARD (0)
+#endif
+#ifdef CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+#define SNAPSHOT_RTT (0x10) //<! SDO round-trip time estimates
+#else
+#define SNAPSHOT_RTT (0)
+#endif
+#ifdef CO_RECOVERY_ENABLE
+#define SNAPSHOT_RECOVERY (0x20) //<! NMT requests to send again after bus-off
+#else
+#define SNAPSHOT_RECOVERY (0)
+#endif
+#ifdef CO_SDO_CHANNELS_ENABLE
+#define SNAPSHOT_CHANNELS (0x40) //<! additional SDO channels configured on the nodes
+#else
+#define SNAPSHOT_CHANNELS (0)
+#endif
+#define SNAPSHOT_FEATURES                                                                       \
+    (SNAPSHOT_SYNC | SNAPSHOT_NMT | SNAPSHOT_HB | SNAPSHOT_GUARD | SNAPSHOT_RTT | SNAPSHOT_RECOVERY \
+     | SNAPSHOT_CHANNELS)
+
+size_t coSnapshotSize(size_t imageLen) {
+    // worst case of all sections: every node seen and measured
+    return SNAPSHOT_HEADER + 1 + (1 + 127 * 3) + 3 + (1 + CO_GUARD_NODES * 5) + (5 + 127 * 5)
+           + (2 + 127 * 2) + (1 + CO_SDO_CHANNELS * 5) + imageLen;
+}
+
+size_t coSnapshotSave(const co_t *co, const void *image, size_t imageLen, uint8_t *buf, size_t len) {
+    assert(co);
+    assert(image || 0 == imageLen);
+    assert(buf);
+    if (len < coSnapshotSize(imageLen) || imageLen > UINT32_MAX) {
+        return 0;
+    }
+    uint8_t *p = buf;
+    p = snapshotPut(p, CO_SNAPSHOT_MAGIC, 4);
+    p = snapshotPut(p, CO_SNAPSHOT_LAYOUT, 1);
+    p = snapshotPut(p, SNAPSHOT_FEATURES, 1);
+    p = snapshotPut(p, imageLen, 4);
+#ifdef CO_SYNC_COUNTER_ENABLE
+    p = snapshotPut(p, co->syncCounter, 1);
+#endif
+#ifdef CO_NMT_TABLE_ENABLE
+    // only nodes that have been seen, most of the table is empty
+    uint8_t *count = p++;
+    *count = 0;
+    for (size_t i = 0; i < 127; ++i) {
+        const co_node_t *node = &co->nodes[i];
+        if (node->seen) {
+            p = snapshotPut(p, i + 1, 1);
+            p = snapshotPut(p, node->state, 1);
+            p = snapshotPut(p, node->bootCount, 1);
+            ++*count;
+        }
+    }
+#endif
+#ifdef CO_HEARTBEAT_ENABLE
+    p = snapshotPut(p, co->hbPeriod, 2);
+    p = snapshotPut(p, co->hbNodeId, 1);
+#endif
+#ifdef CO_NODE_GUARDING_ENABLE
+    uint8_t *guards = p++;
+    *guards = 0;
+    for (size_t i = 0; i < CO_GUARD_NODES; ++i) {
+        const co_guard_t *g = &co->guards[i];
+        if (0 != g->nodeId) {
+            p = snapshotPut(p, g->nodeId, 1);
+            p = snapshotPut(p, g->guardTime, 2);
+            p = snapshotPut(p, g->lifeTimeFactor, 1);
+            p = snapshotPut(p, g->lost, 1);
+            ++*guards;
+        }
+    }
+#endif
+#ifdef CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+    p = snapshotPut(p, co->rttBus.srtt, 2);
+    p = snapshotPut(p, co->rttBus.rttvar, 2);
+    uint8_t *rtts = p++;
+    *rtts = 0;
+    for (size_t i = 0; i < 127; ++i) {
+        const co_rtt_t *rtt = &co->rtt[i];
+        if (0 != rtt->rttvar) {
+            p = snapshotPut(p, i + 1, 1);
+            p = snapshotPut(p, rtt->srtt, 2);
+            p = snapshotPut(p, rtt->rttvar, 2);
+            ++*rtts;
+        }
+    }
+#endif
+#ifdef CO_RECOVERY_ENABLE
+    p = snapshotPut(p, co->nmtLast, 1);
+    uint8_t *reqs = p++;
+    *reqs = 0;
+    for (size_t i = 0; i < 127; ++i) {
+        if (0 != co->nmtNodes[i]) {
+            p = snapshotPut(p, i + 1, 1);
+            p = snapshotPut(p, co->nmtNodes[i], 1);
+            ++*reqs;
+        }
+    }
+#endif
+#ifdef CO_SDO_CHANNELS_ENABLE
+    uint8_t *channels = p++;
+    *channels = 0;
+    for (size_t i = 0; i < CO_SDO_CHANNELS; ++i) {
+        const co_sdo_channel_t *channel = &co->sdoChannels[i];
+        if (0 != channel->nodeId) {
+            p = snapshotPut(p, channel->nodeId, 1);
+            p = snapshotPut(p, channel->request, 2);
+            p = snapshotPut(p, channel->response, 2);
+            ++*channels;
+        }
+    }
+#endif
+    memcpy(p, image, imageLen);
+    return (size_t)(p - buf) + imageLen;
+}
+
+int coSnapshotLoad(co_t *co, const uint8_t *buf, size_t len, void *image, size_t imageLen) {
+    assert(co);
+    assert(buf);
+    assert(image || 0 == imageLen);
+    // validate first, a malformed snapshot leaves the instance untouched
+    if (NULL == snapshotParse(NULL, buf, len, imageLen)) {
+        return -1;
+    }
+    const uint8_t *p = snapshotParse(co, buf, len, imageLen);
+    memcpy(image, p, imageLen);
+    return 0;
+}
+
+size_t coStandbySize(size_t imageLen) {
+    return sizeof(co_standby_t) + coSnapshotSize(imageLen);
+}
+
+int coStandbyInit(co_standby_t *standby, size_t imageLen) {
+    assert(standby);
+    if (coSnapshotSize(imageLen) > UINT32_MAX) {
+        return -1;
+    }
+    standby->magic = 0; // invalid until fully initialized
+    atomic_store_explicit(&standby->seq, 0, memory_order_relaxed);
+    standby->size = coSnapshotSize(imageLen);
+    standby->len = 0;
+    atomic_thread_fence(memory_order_release);
+    standby->magic = CO_STANDBY_MAGIC;
+    return 0;
+}
+
+int coStandbyPublish(co_t *co, co_standby_t *standby, const void *image, size_t imageLen) {
+    assert(co);
+    assert(standby && CO_STANDBY_MAGIC == standby->magic);
+    assert(image || 0 == imageLen);
+    unsigned seq = atomic_load_explicit(&standby->seq, memory_order_relaxed);
+    atomic_store_explicit(&standby->seq, seq + 1, memory_order_relaxed); // odd, writing
+    atomic_thread_fence(memory_order_release);
+    size_t len = coSnapshotSave(co, image, imageLen, standby->data, standby->size);
+    standby->len = len;
+    atomic_store_explicit(&standby->seq, seq + 2, memory_order_release); // even, done
+    return (0 == len) ? -1 : 0;
+}
+
+int coStandbyFollow(co_t *co, const co_standby_t *standby, void *image, size_t imageLen, uint8_t *buf,
+                    size_t len, uint32_t timeout) {
+    assert(co);
+    assert(co->ms);
+    assert(standby);
+    assert(image || 0 == imageLen);
+    assert(buf);
+    if (CO_STANDBY_MAGIC != standby->magic) {
+        return -1;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    unsigned begin = atomic_load_explicit((atomic_uint *)&standby->seq, memory_order_acquire);
+    if (0 == begin) {
+        return -1; // active master never published
+    }
+    if (begin / 2 == co->standbyVersion) {
+        // nothing new, also if the active master died while publishing
+        return (0 != haveTimeout(co, co->standbyChanged, timeout)) ? 1 : 0;
+    }
+    for (unsigned attempt = 0; attempt < CO_STANDBY_READ_RETRIES; ++attempt) {
+        begin = atomic_load_explicit((atomic_uint *)&standby->seq, memory_order_acquire);
+        if (begin & 1) {
+            continue; // writer is active
+        }
+        uint32_t used = standby->len;
+        used = (used < standby->size) ? used : standby->size;
+        if (used > len) {
+            return -1;
+        }
+        memcpy(buf, standby->data, used);
+        atomic_thread_fence(memory_order_acquire);
+        unsigned end = atomic_load_explicit((atomic_uint *)&standby->seq, memory_order_relaxed);
+        if (begin != end) {
+            continue; // torn copy
+        }
+        if (0 != coSnapshotLoad(co, buf, used, image, imageLen)) {
+            return -1;
+        }
+        co->standbyVersion = begin / 2;
+        co->standbyChanged = co->ms();
+        return 0;
+    }
+    // writer doesn't finish, it may have died while publishing
+    return (0 != haveTimeout(co, co->standbyChanged, timeout)) ? 1 : 0;
+}
+
+static uint8_t *snapshotPut(uint8_t *p, uint32_t value, size_t n) {
+    assert(p);
+    assert(1 <= n && n <= 4);
+    for (size_t i = 0; i < n; ++i) {
+        *p++ = (uint8_t)(value >> (8 * i));
+    }
+    return p;
+}
+
+static int snapshotGet(const uint8_t **p, const uint8_t *end, size_t n, uint32_t *value) {
+    assert(p && *p);
+    assert(end);
+    assert(1 <= n && n <= 4);
+    assert(value);
+    if ((size_t)(end - *p) < n) {
+        return -1;
+    }
+    *value = 0;
+    for (size_t i = 0; i < n; ++i) {
+        *value |= (uint32_t)*(*p)++ << (8 * i);
+    }
+    return 0;
+}
+
+static const uint8_t *snapshotParse(co_t *co, const uint8_t *buf, size_t len, size_t imageLen) {
+    assert(buf);
+    const uint8_t *p = buf;
+    const uint8_t *end = buf + len;
+    uint32_t v, n;
+    if (0 != snapshotGet(&p, end, 4, &v) || CO_SNAPSHOT_MAGIC != v
+        || 0 != snapshotGet(&p, end, 1, &v) || CO_SNAPSHOT_LAYOUT != v
+        || 0 != snapshotGet(&p, end, 1, &v) || SNAPSHOT_FEATURES != v
+        || 0 != snapshotGet(&p, end, 4, &v) || imageLen != v) {
+        return NULL; // not a snapshot of the same build
+    }
+    uint32_t now = co ? co->ms() : 0;
+#ifdef CO_SYNC_COUNTER_ENABLE
+    if (0 != snapshotGet(&p, end, 1, &v)) {
+        return NULL;
+    }
+    if (co) {
+        co->syncCounter = v;
+    }
+#endif
+#ifdef CO_NMT_TABLE_ENABLE
+    if (0 != snapshotGet(&p, end, 1, &n) || 127 < n) {
+        return NULL;
+    }
+    if (co) {
+        for (size_t i = 0; i < 127; ++i) {
+            co->nodes[i] = (co_node_t){.state = CO_NMT_STATE_UNKNOWN};
+        }
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t nodeId, state, bootCount;
+        if (0 != snapshotGet(&p, end, 1, &nodeId) || 0 == nodeId || 127 < nodeId
+            || 0 != snapshotGet(&p, end, 1, &state)
+            || 0 != snapshotGet(&p, end, 1, &bootCount)) {
+            return NULL;
+        }
+        if (co) {
+            // a full heartbeat period for the node from now on
+            co->nodes[nodeId - 1] =
+                (co_node_t){.lastSeen = now, .state = state, .bootCount = bootCount, .seen = 1};
+        }
+    }
+#endif
+#ifdef CO_HEARTBEAT_ENABLE
+    uint32_t hbPeriod, hbNodeId;
+    if (0 != snapshotGet(&p, end, 2, &hbPeriod) || 0 != snapshotGet(&p, end, 1, &hbNodeId)) {
+        return NULL;
+    }
+    if (co) {
+        co->hbPeriod = hbPeriod;
+        co->hbNodeId = hbNodeId;
+        co->hbLast = now - hbPeriod; // send heartbeat with next cycle
+    }
+#endif
+#ifdef CO_NODE_GUARDING_ENABLE
+    if (0 != snapshotGet(&p, end, 1, &n) || CO_GUARD_NODES < n) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < CO_GUARD_NODES; ++i) {
+        uint32_t nodeId = 0, guardTime = 0, lifeTimeFactor = 0, lost = 0;
+        if (i < n
+            && (0 != snapshotGet(&p, end, 1, &nodeId) || 0 == nodeId || 127 < nodeId
+                || 0 != snapshotGet(&p, end, 2, &guardTime)
+                || 0 != snapshotGet(&p, end, 1, &lifeTimeFactor)
+                || 0 != snapshotGet(&p, end, 1, &lost))) {
+            return NULL;
+        }
+        if (co) {
+            co->guards[i] = (co_guard_t){
+                .lastRequest = now - guardTime, // request right away
+                .lastResponse = now,
+                .guardTime = guardTime,
+                .lifeTimeFactor = lifeTimeFactor,
+                .toggle = 2, // an answer may have been lost with the active master
+                .lost = lost,
+                .nodeId = nodeId};
+        }
+    }
+#endif
+#if defined(CO_HEARTBEAT_ENABLE) || defined(CO_NODE_GUARDING_ENABLE)
+    if (co) {
+        co->timerNext = now;
+    }
+#endif
+#ifdef CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+    uint32_t srtt, rttvar;
+    if (0 != snapshotGet(&p, end, 2, &srtt) || 0 != snapshotGet(&p, end, 2, &rttvar)
+        || 0 != snapshotGet(&p, end, 1, &n) || 127 < n) {
+        return NULL;
+    }
+    if (co) {
+        co->rttBus = (co_rtt_t){.srtt = srtt, .rttvar = rttvar};
+        memset(co->rtt, 0, sizeof(co->rtt));
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t nodeId;
+        if (0 != snapshotGet(&p, end, 1, &nodeId) || 0 == nodeId || 127 < nodeId
+            || 0 != snapshotGet(&p, end, 2, &srtt) || 0 != snapshotGet(&p, end, 2, &rttvar)) {
+            return NULL;
+        }
+        if (co) {
+            co->rtt[nodeId - 1] = (co_rtt_t){.srtt = srtt, .rttvar = rttvar};
+        }
+    }
+#endif
+#ifdef CO_RECOVERY_ENABLE
+    if (0 != snapshotGet(&p, end, 1, &v) || 0 != snapshotGet(&p, end, 1, &n) || 127 < n) {
+        return NULL;
+    }
+    if (co) {
+        co->nmtLast = v;
+        memset(co->nmtNodes, 0, sizeof(co->nmtNodes));
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t nodeId;
+        if (0 != snapshotGet(&p, end, 1, &nodeId) || 0 == nodeId || 127 < nodeId
+            || 0 != snapshotGet(&p, end, 1, &v)) {
+            return NULL;
+        }
+        if (co) {
+            co->nmtNodes[nodeId - 1] = v;
+        }
+    }
+#endif
+#ifdef CO_SDO_CHANNELS_ENABLE
+    if (0 != snapshotGet(&p, end, 1, &n) || CO_SDO_CHANNELS < n) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < CO_SDO_CHANNELS; ++i) {
+        uint32_t nodeId = 0, request = 0, response = 0;
+        if (i < n
+            && (0 != snapshotGet(&p, end, 1, &nodeId) || 0 == nodeId || 127 < nodeId
+                || 0 != snapshotGet(&p, end, 2, &request) || !SDO_CHANNEL_COB_ID(request)
+                || 0 != snapshotGet(&p, end, 2, &response) || !SDO_CHANNEL_COB_ID(response))) {
+            return NULL;
+        }
+        if (co) {
+            // the nodes keep their configuration, only the registration is restored
+            co->sdoChannels[i] = (co_sdo_channel_t){
+                .request = request,
+                .response = response,
+                .nodeId = nodeId};
+        }
+    }
+#endif
+    (void)now; // unused without timers
+    (void)n;   // unused without tables
+    if ((size_t)(end - p) != imageLen) {
+        return NULL;
+    }
+    return p;
+}
+#endif
+
+#ifdef CO_FIRMWARE_ENABLE
+int coFirmwareStart(co_t *co, co_fw_t *fw) {
+    assert(co);
+    assert(co->tx);
+    assert(co->ms);
+    assert(fw);
+    assert(fw->image || 0 == fw->len);
+    assert(fw->nodes || 0 == fw->n);
+    if (0 == fw->len || fw->len > UINT32_MAX || 0 == fw->program) {
+        return -1;
+    }
+    fw->crc = fwCrc(fw->image, fw->len);
+    fw->next = 0;
+    for (size_t i = 0; i < fw->n; ++i) {
+        co_fw_node_t *node = &fw->nodes[i];
+        assert(node->nodeId > 0 && node->nodeId <= 127);
+        *node = (co_fw_node_t){
+            .nodeId = node->nodeId,
+            .state = (0 != fw->ident) ? CO_FW_IDENT : CO_FW_STOP};
+        fwRequest(co, fw, node);
+    }
+    return 0;
+}
+
+int coFirmwareWork(co_t *co, co_fw_t *fw) {
+    assert(co);
+    assert(co->rx);
+    assert(fw);
+    // process responses
+    co_msg_t msg = {0};
+    int ret;
+    while (0 == (ret = receive(co, &msg))) {
+        co_fw_node_t *node = NULL;
+        if (COB_ID_TSDO == getCOBIDType(&msg) && 8 == msg.len) {
+            for (size_t i = 0; i < fw->n && NULL == node; ++i) {
+                if (getNodeId(&msg) == fw->nodes[i].nodeId && CO_FW_DONE > fw->nodes[i].state) {
+                    node = &fw->nodes[i];
+                }
+            }
+        }
+        if (NULL != node) {
+            fwResponse(co, fw, node, &msg);
+        } else {
+            dispatch(co, &msg); // not for us, let background services see it
+        }
+    }
+    if (-1 == ret) {
+        return -1; // forward error of rx callback
+    }
+    // requests first, they are few and the nodes wait for them
+    int full = 0; // transmit queue is full, try again with next call
+    for (size_t i = 0; i < fw->n && !full; ++i) {
+        co_fw_node_t *node = &fw->nodes[i];
+        if (CO_FW_DONE > node->state && node->request) {
+            full = (0 != fwRequest(co, fw, node));
+        }
+    }
+    // send segments of all nodes interleaved until the transmit queue is full
+    for (size_t idle = 0; idle < fw->n && !full;) {
+        co_fw_node_t *node = &fw->nodes[fw->next];
+        fw->next = (fw->next + 1) % fw->n;
+        if (CO_FW_BLOCK != node->state) {
+            ++idle;
+            continue;
+        }
+        full = (0 != fwSegment(co, fw, node));
+        idle = 0;
+    }
+    // supervise nodes
+    int busy = 0;
+    for (size_t i = 0; i < fw->n; ++i) {
+        co_fw_node_t *node = &fw->nodes[i];
+        if (CO_FW_DONE <= node->state) {
+            continue; // finished
+        }
+        if (0 != haveTimeout(co, node->start, CO_FW_TIMEOUT)) {
+            fwFail(co, fw, node, 0x05040000); // SDO protocol timed out
+            continue;
+        }
+        busy = 1;
+    }
+    return busy;
+}
+
+static int fwRequest(co_t *co, const co_fw_t *fw, co_fw_node_t *node) {
+    assert(co);
+    assert(co->tx);
+    assert(co->ms);
+    assert(fw);
+    assert(node);
+    co_msg_t msg;
+    switch (node->state) {
+    case CO_FW_IDENT:
+        sdoReadMsg(&msg, node->nodeId, 0x1f56, fw->program);
+        break;
+    case CO_FW_STOP:
+        sdoWriteMsg(&msg, node->nodeId, 0x1f51, fw->program, 0x00, 1);
+        break;
+    case CO_FW_CLEAR:
+        sdoWriteMsg(&msg, node->nodeId, 0x1f51, fw->program, 0x03, 1);
+        break;
+    case CO_FW_INIT:
+        msg = (co_msg_t){
+            .cobId = COB_ID_RSDO + node->nodeId, // receive SDO channel
+            .len = 8,
+            .data = {
+                0xc6, // client command specifier, block download initiate, CRC supported, size indicated
+                0x50, 0x1f, fw->program,
+                // size, LSB first!
+                fw->len & 0xff, (fw->len >> 8) & 0xff, (fw->len >> 16) & 0xff, (fw->len >> 24) & 0xff}};
+        break;
+    case CO_FW_END: {
+        size_t last = (fw->len - 1) % 7 + 1; // bytes of data in the last segment
+        msg = (co_msg_t){
+            .cobId = COB_ID_RSDO + node->nodeId, // receive SDO channel
+            .len = 8,
+            .data = {
+                0xc1 | ((7 - last) << 2), // client command specifier, block download end, unused bytes
+                fw->crc & 0xff, (fw->crc >> 8) & 0xff}};
+        break;
+    }
+    case CO_FW_START:
+        sdoWriteMsg(&msg, node->nodeId, 0x1f51, fw->program, 0x01, 1);
+        break;
+    default:
+        return 0; // no request in this step
+    }
+    node->start = co->ms();
+    int ret = sdoTx(co, &msg, 1);
+    node->request = (0 != ret); // not sent, try again with next call
+    return (-1 == ret) ? -1 : 0;
+}
+
+static void fwResponse(co_t *co, const co_fw_t *fw, co_fw_node_t *node, const co_msg_t *msg) {
+    assert(co);
+    assert(fw);
+    assert(node);
+    assert(msg);
+    uint8_t cs = msg->data[0];
+    if (0x80 == cs) {
+        if (CO_FW_IDENT == node->state) {
+            // no software identification, e.g. a bootloader, download anyway
+            node->state = CO_FW_STOP;
+            fwRequest(co, fw, node);
+            return;
+        }
+        if (CO_FW_STOP == node->state) {
+            // a bootloader has no program to stop, go on with clearing
+            node->state = CO_FW_CLEAR;
+            fwRequest(co, fw, node);
+            return;
+        }
+        node->abort =
+            msg->data[4] | (msg->data[5] << 8) | (msg->data[6] << 16) | ((uint32_t)msg->data[7] << 24);
+        node->state = CO_FW_FAILED;
+        return;
+    }
+    // block acknowledges and ends carry no index, all other responses do
+    int match = (fw->program == msg->data[3] && 0x1f == msg->data[2]);
+    uint32_t ident;
+    switch (node->state) {
+    case CO_FW_IDENT:
+        if (!match || 0x56 != msg->data[1]) {
+            return; // stale response of a previous request
+        }
+        if (0 == sdoReadResult(msg, &ident, 4) && fw->ident == ident) {
+            node->state = CO_FW_SKIPPED; // already up to date
+            return;
+        }
+        node->state = CO_FW_STOP;
+        break;
+    case CO_FW_STOP:
+    case CO_FW_CLEAR:
+    case CO_FW_START:
+        if (!match || 0x51 != msg->data[1]) {
+            return; // stale response of a previous request
+        }
+        if (0 != sdoWriteResult(msg)) {
+            fwFail(co, fw, node, 0x05040001); // command specifier not valid
+            return;
+        }
+        if (CO_FW_START == node->state) {
+            node->state = CO_FW_DONE;
+            return;
+        }
+        node->state = (CO_FW_STOP == node->state) ? CO_FW_CLEAR : CO_FW_INIT;
+        break;
+    case CO_FW_INIT:
+        if (!match || 0x50 != msg->data[1]) {
+            return; // stale response of a previous request
+        }
+        if (0xa0 != (cs & 0xe3) || 0 == msg->data[4] || 127 < msg->data[4]) {
+            fwFail(co, fw, node, 0x05040001); // command specifier not valid
+            return;
+        }
+        node->crc = (0 != (cs & 0x04));
+        node->blksize = msg->data[4];
+        node->pos = 0;
+        node->seq = 0;
+        node->state = CO_FW_BLOCK;
+        node->start = co->ms();
+        return;
+    case CO_FW_BLOCK: // the node may acknowledge early after a lost segment
+    case CO_FW_ACK:
+        if (0xa2 != (cs & 0xe3) || msg->data[1] > node->seq || 0 == msg->data[2] || 127 < msg->data[2]) {
+            fwFail(co, fw, node, 0x05040001); // command specifier not valid
+            return;
+        }
+        // segments after the last acknowledged one are sent again
+        node->pos += (size_t)msg->data[1] * 7;
+        if (node->pos >= fw->len) {
+            node->pos = fw->len;
+            node->state = CO_FW_END;
+            break;
+        }
+        node->blksize = msg->data[2];
+        node->seq = 0;
+        node->state = CO_FW_BLOCK;
+        node->start = co->ms();
+        return;
+    case CO_FW_END:
+        if (0xa1 != (cs & 0xe3)) {
+            fwFail(co, fw, node, 0x05040001); // command specifier not valid
+            return;
+        }
+        node->state = CO_FW_START;
+        break;
+    default:
+        return;
+    }
+    fwRequest(co, fw, node);
+}
+
+static int fwSegment(co_t *co, const co_fw_t *fw, co_fw_node_t *node) {
+    assert(co);
+    assert(co->tx);
+    assert(fw);
+    assert(node);
+    assert(CO_FW_BLOCK == node->state);
+    size_t offset = node->pos + (size_t)node->seq * 7;
+    assert(offset < fw->len);
+    size_t len = (fw->len - offset < 7) ? fw->len - offset : 7;
+    int last = (fw->len - offset <= 7);
+    co_msg_t msg = {
+        .cobId = COB_ID_RSDO + node->nodeId, // receive SDO channel
+        .len = 8,
+        .data = {(last ? 0x80 : 0x00) | (node->seq + 1)}}; // last segment flag, sequence number
+    memcpy(&msg.data[1], fw->image + offset, len);
+    if (0 != sdoTx(co, &msg, 1)) {
+        return -1;
+    }
+    if (++node->seq == node->blksize || last) {
+        node->state = CO_FW_ACK; // wait for acknowledge of the sub-block
+        node->start = co->ms();
+    }
+    return 0;
+}
+
+static void fwFail(co_t *co, const co_fw_t *fw, co_fw_node_t *node, uint32_t abort) {
+    assert(co);
+    assert(co->tx);
+    assert(fw);
+    assert(node);
+    if (CO_FW_INIT <= node->state && CO_FW_END >= node->state) {
+        // tell the node, it would wait for the rest of the block download
+        co_msg_t msg = {
+            .cobId = COB_ID_RSDO + node->nodeId, // receive SDO channel
+            .len = 8,
+            .data = {
+                0x80, // abort transfer
+                0x50, 0x1f, fw->program,
+                abort & 0xff, (abort >> 8) & 0xff, (abort >> 16) & 0xff, (abort >> 24) & 0xff}};
+        sdoTx(co, &msg, 1);
+    }
+    node->abort = abort;
+    node->state = CO_FW_FAILED;
+}
+
+static uint16_t fwCrc(const uint8_t *data, size_t len) {
+    assert(data || 0 == len);
+    uint16_t crc = 0x0000;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+#endif
+
+#ifdef CO_MPDO_ENABLE
+int coMPDOWrite(co_t *co, uint16_t cobId, uint8_t nodeId, uint16_t index, uint8_t subIndex, uint32_t data,
+                size_t len) {
+    assert(co);
+    assert(co->tx);
+    assert(cobId > 0 && cobId <= 0x7ff);
+    assert(nodeId <= 127);
+    assert(len > 0 && len <= 4);
+    // MPDOs are always 8 bytes, unused data bytes are 0
+    co_msg_t msg = {
+        .cobId = cobId,
+        .len = 8,
+        .data = {0x80 | nodeId, index & 0xff, index >> 8, subIndex}};
+    for (size_t i = 0; i < len; ++i) {
+        msg.data[4 + i] = (data >> (8 * i)) & 0xff;
+    }
+    return co->tx(&msg);
+}
+
+int coMPDOListen(co_t *co, uint16_t cobId) {
+    assert(co);
+    assert(cobId > 0 && cobId <= 0x7ff);
+    uint16_t *unused = NULL;
+    for (size_t i = 0; i < CO_MPDO_LISTEN; ++i) {
+        if (cobId == co->mpdoListen[i]) {
+            return 0; // already registered
+        } else if (0 == co->mpdoListen[i]) {
+            unused = &co->mpdoListen[i];
+        }
+    }
+    if (NULL == unused) {
+        return -1; // no space left
+    }
+    *unused = cobId;
+    return 0;
+}
+
+static int mpdoReceive(co_t *co, const co_msg_t *msg) {
+    assert(co);
+    assert(msg);
+    size_t i = 0;
+    while (i < CO_MPDO_LISTEN && msg->cobId != co->mpdoListen[i]) {
+        ++i;
+    }
+    if (CO_MPDO_LISTEN == i || 0 == msg->cobId) {
+        return 0; // not a MPDO
+    }
+    if (8 != msg->len || 0 != (msg->data[0] & 0x80) || NULL == co->mpdo) {
+        return 1; // malformed, destination address mode or nobody interested
+    }
+    uint8_t nodeId = msg->data[0];
+    uint16_t index = msg->data[1] | (msg->data[2] << 8);
+    uint8_t subIndex = msg->data[3];
+    if (NULL != co->mpdoScan) {
+        // only objects in the scanner list
+        size_t k = 0;
+        for (; k < co->mpdoScanN; ++k) {
+            const co_mpdo_scan_t *scan = &co->mpdoScan[k];
+            if ((0 == scan->nodeId || nodeId == scan->nodeId) && index == scan->index
+                && subIndex >= scan->subIndex && subIndex - scan->subIndex < scan->count) {
+                break;
+            }
+        }
+        if (k == co->mpdoScanN) {
+            return 1;
+        }
+    }
+    uint32_t data =
+        msg->data[4] | (msg->data[5] << 8) | (msg->data[6] << 16) | ((uint32_t)msg->data[7] << 24);
+    co->mpdo(nodeId, index, subIndex, data);
+    return 1;
+}
+#endif
+
+#ifdef CO_TRACE_ENABLE
+size_t coLogSplit(const char *data, size_t len, size_t n, size_t *offsets) {
+    assert(data || 0 == len);
+    assert(n > 0);
+    assert(offsets);
+    size_t parts = 0;
+    offsets[0] = 0;
+#ifdef CO_BLOG_ENABLE
+    size_t blocks = coBlogIndex(data, len, NULL, NULL, 0);
+    if (0 < blocks) {
+        // binary log, split at block borders
+        size_t pos = 0;
+        for (size_t block = 0; block < blocks; ++block) {
+            if (0 < block && block >= (parts + 1) * blocks / n) {
+                offsets[++parts] = pos;
+            }
+            pos += blogGet((const uint8_t *)data + pos + 4, 4);
+        }
+        offsets[++parts] = len;
+        return parts;
+    }
+#endif
+    for (size_t i = 1; i <= n && offsets[parts] < len; ++i) {
+        size_t pos = (i < n) ? len / n * i : len;
+        if (pos <= offsets[parts]) {
+            continue; // previous part already covers it
+        }
+        // move to start of next line
+        const char *eol = (pos < len) ? memchr(data + pos - 1, '\n', len - pos + 1) : NULL;
+        offsets[++parts] = (NULL == eol) ? len : (size_t)(eol - data) + 1;
+    }
+    return parts;
+}
+
+void coTraceAnalyze(co_trace_t *trace, co_log_t *log) {
+    assert(trace);
+    assert(log);
+    co_msg_t msg;
+    uint64_t ts;
+    uint8_t master;
+    while (0 == coLogNext(log, &msg, &ts, &master)) {
+        traceFrame(trace, &msg, ts);
+        if (NULL != trace->refs && trace->indexed == trace->count - 1 && trace->indexed < trace->refsLen) {
+            // append to the list of the COB-ID
+            uint32_t number = ++trace->indexed;
+            uint16_t cobId = msg.cobId & 0x7ff;
+            trace->refs[number - 1] = (co_trace_ref_t){.pos = trace->base + log->framePos, .next = 0};
+            if (0 == trace->head[cobId]) {
+                trace->head[cobId] = number;
+            } else {
+                trace->refs[trace->tail[cobId] - 1].next = number;
+            }
+            trace->tail[cobId] = number;
+        }
+    }
+}
+
+void coTraceFinish(co_trace_t *trace) {
+    assert(trace);
+    if (0 != trace->syncPeriod && trace->last - trace->syncTs >= trace->syncPeriod) {
+        traceCycle(trace);
+    }
+    trace->syncTs = 0; // cycle is accounted
+}
+
+void coTraceMerge(co_trace_t *trace, const co_trace_t *part) {
+    assert(trace);
+    assert(part);
+    if (0 == part->count) {
+        return;
+    }
+    if (0 == trace->count || part->first < trace->first) {
+        trace->first = part->first;
+    }
+    if (part->last > trace->last) {
+        trace->last = part->last;
+    }
+    if (NULL != trace->refs && NULL != part->refs && trace->indexed == trace->count
+        && part->indexed <= trace->refsLen - trace->indexed) {
+        // append index of part, numbers of its frames move behind the ones of trace
+        uint32_t offset = trace->indexed;
+        for (uint32_t i = 0; i < part->indexed; ++i) {
+            co_trace_ref_t ref = part->refs[i];
+            ref.next = (0 == ref.next) ? 0 : ref.next + offset;
+            trace->refs[offset + i] = ref;
+        }
+        for (size_t i = 0; i < 2048; ++i) {
+            if (0 == part->head[i]) {
+                continue;
+            }
+            if (0 == trace->head[i]) {
+                trace->head[i] = part->head[i] + offset;
+            } else {
+                trace->refs[trace->tail[i] - 1].next = part->head[i] + offset;
+            }
+            trace->tail[i] = part->tail[i] + offset;
+        }
+        trace->indexed += part->indexed;
+    }
+    trace->count += part->count;
+    trace->syncs += part->syncs;
+    for (size_t i = 0; i < 2048; ++i) {
+        trace->frames[i] += part->frames[i];
+    }
+    if (NULL != trace->loadBits && NULL != part->loadBits) {
+        size_t slots = (part->loadSlots < trace->loadSlots) ? part->loadSlots : trace->loadSlots;
+        for (size_t i = 0; i < slots; ++i) {
+            trace->loadBits[i] += part->loadBits[i];
+        }
+    }
+    for (size_t i = 0; i < 127; ++i) {
+        co_trace_node_t *node = &trace->nodes[i];
+        const co_trace_node_t *other = &part->nodes[i];
+        latencyMerge(&node->pdoLatency, &other->pdoLatency);
+        latencyMerge(&node->sdoRtt, &other->sdoRtt);
+        for (size_t j = 0; j < CO_TRACE_BUCKETS; ++j) {
+            node->pdoHist[j] += other->pdoHist[j];
+        }
+        node->missed += other->missed;
+        if (0 == other->emcyCount) {
+            continue;
+        }
+        if (0 == node->emcyCount || other->emcyFirstTs < node->emcyFirstTs) {
+            node->emcyFirstTs = other->emcyFirstTs;
+        }
+        if (0 == node->emcyCount || other->emcyLastTs >= node->emcyLastTs) {
+            node->emcyLastTs = other->emcyLastTs;
+            node->emcyLast = other->emcyLast;
+        }
+        node->emcyCount += other->emcyCount;
+    }
+    // continue at the end of part, e.g. for coTraceFinish()
+    trace->syncTs = part->syncTs;
+    trace->syncPeriod = part->syncPeriod;
+    for (size_t i = 0; i < 4; ++i) {
+        trace->active[i] |= part->active[i];
+        trace->seen[i] = part->seen[i];
+    }
+    memcpy(trace->sdoTs, part->sdoTs, sizeof(trace->sdoTs));
+}
+
+static void traceFrame(co_trace_t *trace, const co_msg_t *msg, uint64_t ts) {
+    assert(trace);
+    assert(msg);
+    co_cob_id_t cobId = getCOBIDType(msg);
+    uint8_t nodeId = getNodeId(msg);
+    // frame counts and bus load
+    if (0 == trace->count) {
+        trace->first = ts;
+        if (0 == trace->start) {
+            trace->start = ts;
+        }
+    }
+    trace->last = ts;
+    ++trace->count;
+    ++trace->frames[msg->cobId & 0x7ff];
+    if (NULL != trace->loadBits && ts >= trace->start) {
+        uint64_t slot = (ts - trace->start) / ((uint64_t)CO_TRACE_LOAD_MS * 1000000);
+        if (slot < trace->loadSlots) {
+            trace->loadBits[slot] += 47 + 8 * msg->len; // standard frame with interframe space
+        }
+    }
+    if (0 == nodeId) {
+        if (COB_ID_SYNC == cobId) {
+            traceCycle(trace);
+            if (0 != trace->syncTs && ts > trace->syncTs) {
+                trace->syncPeriod = ts - trace->syncTs;
+            }
+            trace->syncTs = ts;
+            ++trace->syncs;
+        }
+        return;
+    }
+    co_trace_node_t *node = &trace->nodes[nodeId - 1];
+    switch (cobId) {
+    case COB_ID_TPDO1:
+        if (0 != trace->syncTs && ts >= trace->syncTs) {
+            uint32_t bit = (uint32_t)1 << ((nodeId - 1) & 0x1f);
+            if (0 == (trace->seen[(nodeId - 1) >> 5] & bit)) {
+                // only first TxPDO of a cycle counts
+                uint64_t ns = ts - trace->syncTs;
+                latencyUpdate(&node->pdoLatency, ns);
+                size_t bucket = 0;
+                for (uint64_t us = ns / 1000; 0 != us && CO_TRACE_BUCKETS - 1 > bucket; us >>= 1) {
+                    ++bucket;
+                }
+                ++node->pdoHist[bucket];
+            }
+            trace->active[(nodeId - 1) >> 5] |= bit;
+            trace->seen[(nodeId - 1) >> 5] |= bit;
+        }
+        break;
+    case COB_ID_RSDO:
+        trace->sdoTs[nodeId - 1] = ts;
+        break;
+    case COB_ID_TSDO:
+        if (0 != trace->sdoTs[nodeId - 1] && ts >= trace->sdoTs[nodeId - 1]) {
+            latencyUpdate(&node->sdoRtt, ts - trace->sdoTs[nodeId - 1]);
+            trace->sdoTs[nodeId - 1] = 0;
+        }
+        break;
+    case COB_ID_EMCY:
+        if (0 == node->emcyCount) {
+            node->emcyFirstTs = ts;
+        }
+        node->emcyLastTs = ts;
+        node->emcyLast = msg->data[0] | (msg->data[1] << 8);
+        ++node->emcyCount;
+        if (trace->emcy) {
+            trace->emcy(nodeId, node->emcyLast, msg->data[2], ts);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void traceCycle(co_trace_t *trace) {
+    assert(trace);
+    if (0 == trace->syncTs) {
+        return; // no cycle yet
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        uint32_t missed = trace->active[i] & ~trace->seen[i];
+        for (size_t bit = 0; 0 != missed; ++bit, missed >>= 1) {
+            if (missed & 1) {
+                ++trace->nodes[i * 32 + bit].missed;
+            }
+        }
+        trace->seen[i] = 0;
+    }
+}
+
+static void latencyMerge(co_latency_t *lat, const co_latency_t *other) {
+    assert(lat);
+    assert(other);
+    if (0 == other->count) {
+        return;
+    }
+    if (0 == lat->count || other->minNs < lat->minNs) {
+        lat->minNs = other->minNs;
+    }
+    if (other->maxNs > lat->maxNs) {
+        lat->maxNs = other->maxNs;
+    }
+    lat->sumNs += other->sumNs;
+    lat->count += other->count;
+}
+#endif
+
+#ifdef CO_GATEWAY_ENABLE
+int coGatewayParse(const char *line, size_t len, co_gw_cmd_t *cmd) {
+    assert(line || 0 == len);
+    assert(cmd);
+    *cmd = (co_gw_cmd_t){0};
+    const char *pos = line;
+    const char *end = line + len;
+    const char *tok;
+    size_t tokLen;
+    int64_t value;
+    // sequence number
+    tokLen = gwToken(&pos, end, &tok);
+    if (3 > tokLen || '[' != tok[0] || ']' != tok[tokLen - 1]
+        || 0 != gwNumber(tok + 1, tokLen - 2, &value) || 0 > value) {
+        return 101;
+    }
+    cmd->seq = (uint32_t)value;
+    // optional net and node, up to the command
+    int64_t addr[2];
+    size_t nAddr = 0;
+    while (0 != (tokLen = gwToken(&pos, end, &tok)) && 0 == gwNumber(tok, tokLen, &value)) {
+        if (2 <= nAddr) {
+            return 101;
+        }
+        addr[nAddr++] = value;
+    }
+    if (0 == tokLen) {
+        return 101; // no command
+    } else if (0 == nAddr) {
+        return 105; // no default node
+    } else if (2 == nAddr && 1 != addr[0]) {
+        return 106; // only one net
+    }
+    value = addr[nAddr - 1];
+    if (0 > value || 127 < value) {
+        return 107;
+    }
+    cmd->nodeId = (uint8_t)value;
+    // command
+    if (gwIs(tok, tokLen, "r") || gwIs(tok, tokLen, "read")) {
+        cmd->op = CO_GW_READ;
+    } else if (gwIs(tok, tokLen, "w") || gwIs(tok, tokLen, "write")) {
+        cmd->op = CO_GW_WRITE;
     } else {
-        return 0; // ok
+        cmd->op = CO_GW_NMT;
+        if (gwIs(tok, tokLen, "start")) {
+            cmd->nmt = CO_NMT_OP;
+        } else if (gwIs(tok, tokLen, "stop")) {
+            cmd->nmt = CO_NMT_STOP;
+        } else if (gwIs(tok, tokLen, "preop") || gwIs(tok, tokLen, "preoperational")) {
+            cmd->nmt = CO_NMT_PRE_OP;
+        } else if (gwIs(tok, tokLen, "reset")) {
+            tokLen = gwToken(&pos, end, &tok);
+            if (gwIs(tok, tokLen, "node")) {
+                cmd->nmt = CO_NMT_RST;
+            } else if (gwIs(tok, tokLen, "comm") || gwIs(tok, tokLen, "communication")) {
+                cmd->nmt = CO_NMT_RST_COM;
+            } else {
+                return 101;
+            }
+        } else {
+            return 100; // unknown or unsupported command
+        }
+        return (0 == gwToken(&pos, end, &tok)) ? 0 : 101;
+    }
+    // SDO command, index, subindex and data type
+    if (0 == cmd->nodeId) {
+        return 107; // SDO can't be broadcast
+    }
+    tokLen = gwToken(&pos, end, &tok);
+    if (0 != gwNumber(tok, tokLen, &value) || 0 > value || 0xffff < value) {
+        return 101;
+    }
+    cmd->index = (uint16_t)value;
+    tokLen = gwToken(&pos, end, &tok);
+    if (0 != gwNumber(tok, tokLen, &value) || 0 > value || 0xff < value) {
+        return 101;
+    }
+    cmd->subIndex = (uint8_t)value;
+    tokLen = gwToken(&pos, end, &tok);
+    if (0 == tokLen) {
+        return 101;
+    } else if (gwIs(tok, tokLen, "b") || gwIs(tok, tokLen, "u8")) {
+        cmd->len = 1;
+    } else if (gwIs(tok, tokLen, "u16")) {
+        cmd->len = 2;
+    } else if (gwIs(tok, tokLen, "u32")) {
+        cmd->len = 4;
+    } else if (gwIs(tok, tokLen, "i8")) {
+        cmd->len = 1;
+        cmd->isSigned = 1;
+    } else if (gwIs(tok, tokLen, "i16")) {
+        cmd->len = 2;
+        cmd->isSigned = 1;
+    } else if (gwIs(tok, tokLen, "i32")) {
+        cmd->len = 4;
+        cmd->isSigned = 1;
+    } else {
+        return 100; // e.g. strings, 64 bit or floating point types
+    }
+    if (CO_GW_WRITE == cmd->op) {
+        tokLen = gwToken(&pos, end, &tok);
+        if (0 != gwNumber(tok, tokLen, &value)) {
+            return 101;
+        }
+        int64_t max = ((int64_t)1 << (cmd->len * 8 - cmd->isSigned)) - 1;
+        int64_t min = cmd->isSigned ? -max - 1 : 0;
+        if (min > value || max < value) {
+            return 101; // value out of range of data type
+        }
+        cmd->data = (uint32_t)value;
+    }
+    return (0 == gwToken(&pos, end, &tok)) ? 0 : 101;
+}
+
+int coGatewayRequest(co_t *co, const char *line, size_t len, void *ctx, char *resp, size_t respLen) {
+    assert(co);
+    assert(co->tx);
+    assert(co->ms);
+    assert(line || 0 == len);
+    assert(resp);
+    co_gw_cmd_t cmd;
+    int error = coGatewayParse(line, len, &cmd);
+    if (0 != error) {
+        return gwFormat(resp, respLen, &cmd, 0, error);
+    } else if (CO_GW_NMT == cmd.op) {
+        error = (0 == coNMTReq(co, cmd.nodeId, cmd.nmt)) ? 0 : 102;
+        return gwFormat(resp, respLen, &cmd, 0, error);
+    }
+    // queue SDO request, free requests are always at the end
+    for (size_t i = 0; i < CO_GATEWAY_REQUESTS; ++i) {
+        if (0 == co->gwReqs[i].state) {
+            co->gwReqs[i] = (co_gw_req_t){.cmd = cmd, .ctx = ctx, .state = 1};
+            gwStart(co);
+            return 0;
+        }
+    }
+    return gwFormat(resp, respLen, &cmd, 0, 102); // too many open requests
+}
+
+int coGatewayResponse(co_t *co, void **ctx, char *resp, size_t respLen) {
+    assert(co);
+    assert(co->ms);
+    assert(ctx);
+    assert(resp);
+    // check in flight requests for timeouts
+    for (size_t i = 0; i < CO_GATEWAY_REQUESTS; ++i) {
+        co_gw_req_t *req = &co->gwReqs[i];
+        if (2 != req->state || 0 == haveTimeout(co, req->start, req->timeout)) {
+            continue; // not in flight or still waiting
+        }
+        if (++req->attempt > SDO_RETRIES) {
+            gwDone(req, 0x05040000); // SDO protocol timed out
+            continue;
+        }
+        // repeat request
+        req->timeout = sdoBackoff(req->timeout);
+        if (0 != gwSend(co, req)) {
+            gwDone(req, 0x08000000); // general error
+        }
+    }
+    gwStart(co);
+    // return oldest finished request
+    for (size_t i = 0; i < CO_GATEWAY_REQUESTS; ++i) {
+        co_gw_req_t *req = &co->gwReqs[i];
+        if (3 != req->state) {
+            continue;
+        } else if (req->discard) {
+            gwRemove(co, i--);
+            continue;
+        }
+        *ctx = req->ctx;
+        int ret = gwFormat(resp, respLen, &req->cmd, req->abort, 0);
+        gwRemove(co, i);
+        return ret;
+    }
+    return 0;
+}
+
+void coGatewayDiscard(co_t *co, void *ctx) {
+    assert(co);
+    for (size_t i = 0; i < CO_GATEWAY_REQUESTS; ++i) {
+        co_gw_req_t *req = &co->gwReqs[i];
+        if (0 == req->state || ctx != req->ctx) {
+            continue;
+        } else if (2 == req->state) {
+            req->discard = 1; // response is still to come, drop it then
+        } else {
+            gwRemove(co, i--);
+        }
+    }
+}
+
+static size_t gwToken(const char **pos, const char *end, const char **tok) {
+    assert(pos && *pos);
+    assert(end);
+    assert(tok);
+    const char *p = *pos;
+    while (p < end && (' ' == *p || '\t' == *p || '\r' == *p || '\n' == *p)) {
+        ++p;
+    }
+    *tok = p;
+    while (p < end && ' ' != *p && '\t' != *p && '\r' != *p && '\n' != *p) {
+        ++p;
+    }
+    *pos = p;
+    return (size_t)(p - *tok);
+}
+
+static int gwIs(const char *tok, size_t len, const char *word) {
+    assert(tok);
+    assert(word);
+    return len == strlen(word) && 0 == memcmp(tok, word, len);
+}
+
+static int gwNumber(const char *tok, size_t len, int64_t *value) {
+    assert(tok);
+    assert(value);
+    int negative = (0 < len && '-' == tok[0]);
+    if (negative) {
+        ++tok;
+        --len;
+    }
+    uint32_t base = 10;
+    if (2 < len && '0' == tok[0] && ('x' == tok[1] || 'X' == tok[1])) {
+        base = 16;
+        tok += 2;
+        len -= 2;
+    }
+    if (0 == len) {
+        return -1;
+    }
+    int64_t number = 0;
+    for (size_t i = 0; i < len; ++i) {
+        char c = tok[i];
+        uint32_t digit;
+        if ('0' <= c && '9' >= c) {
+            digit = c - '0';
+        } else if (16 == base && 'a' <= (c | 0x20) && 'f' >= (c | 0x20)) {
+            digit = (c | 0x20) - 'a' + 10; // lower case
+        } else {
+            return -1;
+        }
+        if (10 == base && 9 < digit) {
+            return -1;
+        }
+        number = number * base + digit;
+        if (0xffffffff < number) {
+            return -1; // larger than any supported data type
+        }
+    }
+    *value = negative ? -number : number;
+    return 0;
+}
+
+static int gwFormat(char *resp, size_t respLen, const co_gw_cmd_t *cmd, uint32_t abort, int error) {
+    assert(resp);
+    assert(cmd);
+    int ret;
+    if (0 != error) {
+        ret = snprintf(resp, respLen, "[%" PRIu32 "] ERROR:%d\r\n", cmd->seq, error);
+    } else if (0 != abort) {
+        ret = snprintf(resp, respLen, "[%" PRIu32 "] ERROR:0x%08" PRIX32 "\r\n", cmd->seq, abort);
+    } else if (CO_GW_READ != cmd->op) {
+        ret = snprintf(resp, respLen, "[%" PRIu32 "] OK\r\n", cmd->seq);
+    } else if (cmd->isSigned) {
+        // sign extend from data type size
+        uint32_t sign = (uint32_t)1 << (cmd->len * 8 - 1);
+        int32_t data = (int32_t)((cmd->data ^ sign) - sign);
+        ret = snprintf(resp, respLen, "[%" PRIu32 "] %" PRId32 "\r\n", cmd->seq, data);
+    } else {
+        ret = snprintf(resp, respLen, "[%" PRIu32 "] %" PRIu32 "\r\n", cmd->seq, cmd->data);
+    }
+    return (0 > ret || respLen <= (size_t)ret) ? -1 : ret;
+}
+
+static int gwSend(co_t *co, co_gw_req_t *req) {
+    assert(co);
+    assert(req);
+    const co_gw_cmd_t *cmd = &req->cmd;
+    co_msg_t msg;
+    if (CO_GW_WRITE == cmd->op) {
+        sdoWriteMsg(&msg, cmd->nodeId, cmd->index, cmd->subIndex, cmd->data, cmd->len);
+    } else {
+        msg = (co_msg_t){
+            .cobId = COB_ID_RSDO + cmd->nodeId, // receive SDO channel
+            .len = 8,
+            .data = {
+                0x40, // client command specifier, SDO client upload initiate
+                cmd->index & 0xff /* index LSB */, (cmd->index >> 8) & 0xff /* index MSB */,
+                cmd->subIndex
+                // no data
+            }};
+    }
+    req->start = co->ms();
+    return (-1 == sdoTx(co, &msg, 1)) ? -1 : 0; // not sent is repeated on timeout
+}
+
+static void gwDone(co_gw_req_t *req, uint32_t abort) {
+    assert(req);
+    req->abort = abort;
+    req->state = 3;
+}
+
+static void gwStart(co_t *co) {
+    assert(co);
+    for (size_t i = 0; i < CO_GATEWAY_REQUESTS; ++i) {
+        co_gw_req_t *req = &co->gwReqs[i];
+        if (1 != req->state) {
+            continue;
+        }
+        // one transfer per node at a time, earlier requests go first
+        uint8_t nodeId = req->cmd.nodeId;
+        int busy = 0;
+        for (size_t j = 0; j < CO_GATEWAY_REQUESTS && !busy; ++j) {
+            busy = (nodeId == co->gwReqs[j].cmd.nodeId
+                    && (2 == co->gwReqs[j].state || (1 == co->gwReqs[j].state && j < i)));
+        }
+#ifdef CO_SDO_ASYNC_ENABLE
+        busy = busy || (NULL != sdoAsyncFind(co, nodeId));
+#endif
+        busy = busy || (nodeId == co->sdoNode); // blocking transfer in progress
+        if (busy) {
+            continue;
+        }
+        req->state = 2;
+        req->attempt = 0;
+        req->timeout = sdoTimeout(co, nodeId);
+        if (0 != gwSend(co, req)) {
+            gwDone(req, 0x08000000); // general error
+        }
+    }
+}
+
+static int gwResponse(co_t *co, const co_msg_t *msg) {
+    assert(co);
+    assert(msg);
+    uint8_t nodeId = getNodeId(msg);
+    co_gw_req_t *req = NULL;
+    for (size_t i = 0; i < CO_GATEWAY_REQUESTS && NULL == req; ++i) {
+        if (2 == co->gwReqs[i].state && nodeId == co->gwReqs[i].cmd.nodeId) {
+            req = &co->gwReqs[i];
+        }
+    }
+    if (NULL == req) {
+        return 0; // no gateway request to this node
+    }
+    co_gw_cmd_t *cmd = &req->cmd;
+    if (8 != msg->len
+        || (cmd->index & 0xff) != msg->data[1]
+        || ((cmd->index >> 8) & 0xff) != msg->data[2]
+        || cmd->subIndex != msg->data[3]) {
+        return 1; // stale response of a previous request, drop it
+    }
+    uint32_t data =
+        msg->data[4] | (msg->data[5] << 8) | (msg->data[6] << 16) | ((uint32_t)msg->data[7] << 24);
+    uint8_t nField = ((4 - cmd->len) << 2); // count of unused bytes of data part
+    uint8_t scs = msg->data[0] & 0xe0;
+    if (0x80 == scs) {
+        gwDone(req, data); // abort code of server
+    } else if (CO_GW_WRITE == cmd->op && 0x60 == scs) {
+        gwDone(req, 0);
+    } else if (CO_GW_READ == cmd->op && 0x40 == scs) {
+        if (0x03 != (msg->data[0] & 0x03)) {
+            gwDone(req, 0x08000000); // not expedited, segmented transfer is not supported
+        } else if (nField != (msg->data[0] & 0x0c)) {
+            gwDone(req, 0x06070010); // data type does not match
+        } else {
+            cmd->data = (4 == cmd->len) ? data : data & (((uint32_t)1 << (cmd->len * 8)) - 1);
+            gwDone(req, 0);
+        }
+    } else {
+        gwDone(req, 0x05040001); // command specifier not valid
+    }
+#ifdef CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+    if (0 == req->attempt) {
+        // Karn's algorithm, same as blocking transfers
+        uint32_t rtt = co->ms() - req->start;
+        rttUpdate(&co->rtt[nodeId - 1], rtt);
+        rttUpdate(&co->rttBus, rtt);
     }
+#endif
+    gwStart(co); // pipeline next request to this node
+    return 1;
 }
+
+static void gwRemove(co_t *co, size_t i) {
+    assert(co);
+    assert(i < CO_GATEWAY_REQUESTS);
+    memmove(&co->gwReqs[i], &co->gwReqs[i + 1], (CO_GATEWAY_REQUESTS - 1 - i) * sizeof(co_gw_req_t));
+    co->gwReqs[CO_GATEWAY_REQUESTS - 1].state = 0;
+}
+#endif
@@ -16,15 +16,37 @@
  *
  * This library implements:
  * - NMT master
+ *    => optional node state table @see CO_NMT_TABLE_ENABLE
+ * - heartbeat producer @see CO_HEARTBEAT_ENABLE
+ * - node guarding @see CO_NODE_GUARDING_ENABLE
  * - SYNC producer
  * - EMCY receiver
  * - TIME producer
  * - PDO receive/transmit
  *    => only one PDO for each
+ *    => to many nodes in one transport call @see coTPDOBatch()
  * - SDO client
  *    => only expedited
- *    => only on default channels
+ *    => on default channels, additional ones per node @see CO_SDO_CHANNELS_ENABLE
  *    => only at max 4 byte data types, (u)int8 - (u)int32
+ *    => optional adaptive timeouts per node @see CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+ * - CAN controller bus-off recovery @see CO_RECOVERY_ENABLE
+ * - CiA402 drive state machine @see CO_CIA402_ENABLE
+ * - receive timestamps @see CO_MSG_TIMESTAMP_ENABLE
+ * - setpoint streaming buffers @see CO_SETPOINT_ENABLE
+ * - process image in shared memory @see CO_SHM_ENABLE
+ * - bus sharing with client processes @see CO_MUX_ENABLE
+ * - CiA309-3 ASCII gateway @see CO_GATEWAY_ENABLE
+ * - routing to another bus @see CO_ROUTER_ENABLE
+ * - replay of recorded bus logs @see CO_REPLAY_ENABLE
+ * - offline analysis of recorded bus logs @see CO_TRACE_ENABLE
+ * - compact binary bus log @see CO_BLOG_ENABLE
+ * - fault injection into the transport @see CO_FAULT_ENABLE
+ * - response-time analysis of the bus @see CO_RTA_ENABLE
+ * - redundant operation on two buses @see CO_REDUNDANT_ENABLE
+ * - hot-standby master with state snapshots @see CO_STANDBY_ENABLE
+ * - program download to many nodes at once @see CO_FIRMWARE_ENABLE
+ * - multiplexed PDOs for SDO-free object writes @see CO_MPDO_ENABLE
  *
  * Mode of operation:
  * - reset/reboot node with NMT
@@ -36,6 +58,8 @@
  *   - receive PDO from node    @see coRPDO()
  *   => received EMCY messages in this cyclic mode are forwarded to application
  *   => no SDO transactions supported in cyclic operation!
+ *      except background configuration  @see CO_SDO_ASYNC_ENABLE
+ *   => rebooted nodes can be reconfigured in the background @see CO_HOTPLUG_ENABLE
  *
  */
 
@@ -61,6 +85,108 @@
 #define CO_TIMEOUT_NMT (3000) //<! timeout in ms to wait for NMT response
 #define CO_TIMEOUT_SDO (1000) //<! timeout in ms to wait for SDO response
 
+/**
+ * @brief Enable/disable setting for adaptive SDO timeouts.
+ *
+ * A fixed SDO timeout has to be chosen for the slowest node and makes every
+ * request to an absent node cost the full CO_TIMEOUT_SDO. With this enabled
+ * the round-trip time of each SDO transfer is measured and a smoothed mean and
+ * variance is kept per node, the same way TCP does it for its retransmission
+ * timer (RFC 6298). The timeout for the next request to that node is derived
+ * from it as mean + 4 * variance and clamped to the range CO_TIMEOUT_SDO_MIN -
+ * CO_TIMEOUT_SDO_MAX. Nodes that never answered yet use the estimate of the
+ * whole bus, or CO_TIMEOUT_SDO if no node answered so far.
+ * A request that times out is sent again up to CO_SDO_RETRIES times, each time
+ * with the timeout doubled (but again at most CO_TIMEOUT_SDO_MAX).
+ * Costs 4 bytes of RAM per node in co_t.
+ */
+// #define CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+
+#define CO_TIMEOUT_SDO_MIN (10)             //<! lower bound in ms of adaptive SDO timeout
+#define CO_TIMEOUT_SDO_MAX (CO_TIMEOUT_SDO) //<! upper bound in ms of adaptive SDO timeout
+#define CO_SDO_RETRIES (3)                  //<! count of retries after an adaptive SDO timeout
+
+/**
+ * @brief Enable/disable setting for background SDO transfers.
+ *
+ * Normally SDO transfers block until the response is received and are not
+ * allowed in cyclic operation. With this enabled a configuration batch can be
+ * written in the background with coSDOWriteBatchAsync(). The request frames
+ * are sent and the responses processed from within coRPDO() and coSYNC(), so
+ * cyclic operation continues undisturbed. At most one background transfer per
+ * node (per SDO channel of the node with CO_SDO_CHANNELS_ENABLE) and
+ * CO_SDO_ASYNC_JOBS transfers in total can be active at once.
+ * Finished transfers are reported to the co_sdo_done_cb_t callback.
+ */
+// #define CO_SDO_ASYNC_ENABLE
+
+#define CO_SDO_ASYNC_JOBS (4) //<! max count of concurrent background SDO transfers
+
+/**
+ * @brief Enable/disable setting for hot-plug of nodes.
+ *
+ * A node that reboots during cyclic operation (e.g. after a power-cycle) comes
+ * back in pre-operational state and with its default configuration. With this
+ * enabled, a configuration batch can be registered per node with
+ * coHotplugRegister(). If coRPDO() receives a boot-up message from such a node,
+ * the configuration is written in the background and the node is afterwards
+ * set to operational again. Every other node keeps cycling.
+ * Requires CO_SDO_ASYNC_ENABLE.
+ */
+// #define CO_HOTPLUG_ENABLE
+
+#define CO_HOTPLUG_NODES (16) //<! max count of nodes that can be registered for hot-plug
+
+#if defined(CO_HOTPLUG_ENABLE) && !defined(CO_SDO_ASYNC_ENABLE)
+#error "CO_HOTPLUG_ENABLE requires CO_SDO_ASYNC_ENABLE"
+#endif
+
+/**
+ * @brief Enable/disable setting for CAN controller error recovery.
+ *
+ * Without this a CAN controller that went bus-off makes every following call
+ * fail until the application restarts it. With this enabled coSYNC() first
+ * checks the controller state with the co_status_cb_t callback. On bus-off the
+ * controller is restarted with the co_restart_cb_t callback (and again every
+ * CO_RECOVERY_RESTART_MS as long as it stays bus-off). Once it is back, the
+ * receive queue is flushed of stale frames, the NMT requests are sent again
+ * (the last broadcast followed by the later ones to single nodes, a reset is
+ * remembered as pre-operational) and the SYNC counter is reset. Bus-off and
+ * error-passive events, failed restarts as well as the recovery time are
+ * counted in co_bus_stats_t.
+ */
+// #define CO_RECOVERY_ENABLE
+
+#define CO_RECOVERY_RESTART_MS (100) //<! time in ms after which a still bus-off controller is restarted
+
+/**
+ * @brief Enable/disable setting for the CiA402 drive state machine.
+ *
+ * Drives following the CiA402 profile have to be walked through their power
+ * state machine with the controlword (0x6040) based on their statusword
+ * (0x6041) until they are in "operation enabled". With this enabled
+ * co402Update() does this for many axes at once, directly on the status- and
+ * controlwords of the PDO process data. It needs no SDO transfers.
+ */
+// #define CO_CIA402_ENABLE
+
+/**
+ * @brief Enable/disable setting for setpoint streaming buffers.
+ *
+ * In interpolated position mode every SYNC needs a new target position. With
+ * this enabled a trajectory planner can fill a co_setpoint_t FIFO per axis
+ * ahead of time with coSetpointPush() while the cyclic part takes exactly one
+ * setpoint per SYNC with coSetpointPop(). The FIFO is lock-free for a single
+ * producer and a single consumer, e.g. main loop and timer interrupt or two
+ * threads. If the planner falls behind, the last setpoint is held or, with
+ * CO_SP_EXTRAPOLATE, linearly extrapolated for at most
+ * CO_SETPOINT_EXTRAPOLATE_MAX cycles and then held. Underruns are counted.
+ */
+// #define CO_SETPOINT_ENABLE
+
+#define CO_SETPOINT_FIFO (16)           //<! setpoints per axis FIFO, must be a power of two
+#define CO_SETPOINT_EXTRAPOLATE_MAX (2) //<! max count of consecutive extrapolated setpoints
+
 /**
  * @brief Argument for coTIME
  *
@@ -69,23 +195,337 @@
  */
 #define CO_TIME_USE_TIMECB (UINT32_MAX)
 
+/**
+ * @brief Enable/disable setting for receive timestamps.
+ *
+ * Adds a nanosecond timestamp to co_msg_t that the rx callback fills with the
+ * time the frame was received, as precise as the transport can provide it
+ * (e.g. hardware timestamps with SO_TIMESTAMPING on SocketCAN). The timestamp
+ * of the last PDO of every node returned by coRPDO() is kept in co_t and, with
+ * CO_SHM_ENABLE, published next to the process image. If the transport also
+ * receives its own frames (loopback, CAN_RAW_RECV_OWN_MSGS on SocketCAN), the
+ * latency of every TxPDO to the preceding SYNC is collected in co_latency_t.
+ */
+// #define CO_MSG_TIMESTAMP_ENABLE
+
+/**
+ * @brief Enable/disable setting for the NMT node state table.
+ *
+ * Keeps track of the NMT state of every node as reported in its heartbeat and
+ * boot-up messages, together with the time it was last seen and how often it
+ * booted. The table is updated from every received frame that passes through
+ * coSimple and can be queried with coNMTState() or read directly from co_t.
+ * coNMTReqConfirm() sends a NMT request and waits until the node reports the
+ * requested state. Nodes must be configured to produce heartbeats (0x1017).
+ * Costs 8 bytes of RAM per node in co_t.
+ */
+// #define CO_NMT_TABLE_ENABLE
+
+/**
+ * @brief Enable/disable setting for the master heartbeat producer.
+ *
+ * Nodes with a heartbeat consumer (0x1016) go into error state if the master
+ * stops sending heartbeats. With this enabled coSYNC() sends a heartbeat of
+ * the master every period set with coHeartbeatProducer().
+ */
+// #define CO_HEARTBEAT_ENABLE
+
+/**
+ * @brief Enable/disable setting for node guarding.
+ *
+ * Legacy nodes without heartbeat are supervised by node guarding: the master
+ * periodically requests the node state with a RTR frame, the node answers
+ * with its state and a toggle bit. With this enabled coSYNC() sends the
+ * guarding requests to every node registered with coGuardRegister() and checks
+ * the life time (guard time * life time factor). A missing or wrong answer is
+ * reported to the co_guard_cb_t callback. Needs support for RTR frames by the
+ * transport, see co_msg_t.
+ */
+// #define CO_NODE_GUARDING_ENABLE
+
+#define CO_GUARD_NODES (8) //<! max count of nodes that can be registered for node guarding
+
+#define CO_TPDO_BATCH (32) //<! max count of PDOs coTPDOBatch() hands over to co_tx_batch_cb_t at once
+
+/**
+ * @brief Enable/disable setting for publishing to shared memory.
+ *
+ * Other processes like HMIs or data loggers often need the current process
+ * data too. With this enabled coShmPublish() copies the process image (and the
+ * NMT node state table if enabled) into a co_shm_t, typically placed in a
+ * named shared memory segment created by the application with shm_open() and
+ * mmap(), sized with coShmSize(). Writes are protected with a seqlock, so any
+ * number of readers can take consistent snapshots with coShmRead() without
+ * system calls and without ever blocking the bus thread.
+ */
+// #define CO_SHM_ENABLE
+
+#define CO_SHM_READ_RETRIES (1000) //<! max count of attempts of coShmRead() while the writer is updating
+
+/**
+ * @brief Enable/disable setting for sharing the bus with other processes.
+ *
+ * Only one coSimple instance can own the CAN interface. With this enabled the
+ * owning process (the daemon) can serve up to CO_MUX_CLIENTS client processes
+ * through co_mux_t. Each client gets a pair of lock-free frame rings, which
+ * are meant to be placed in shared memory. A client simply calls coRingRx() and
+ * coRingTx() on its rings from the rx and tx callbacks of its own co_t and can
+ * then use the normal blocking API, e.g. for SDO transfers.
+ * SDO channels are arbitrated between the clients and the daemon's own
+ * transfers: while one of them has a transfer to a node in progress, requests
+ * of the others to that node wait, and SDO responses only go to the owner of
+ * the transfer. SYNC and PDOs stay inside the daemon, clients get the process
+ * data zero-copy with CO_SHM_ENABLE. Every other received frame is forwarded
+ * to all clients. coSimple only provides the rings and the arbitration, the
+ * daemon process, how clients find the shared memory (e.g. a Unix socket
+ * handshake) and how they are woken up is left to the application.
+ */
+// #define CO_MUX_ENABLE
+
+#define CO_MUX_CLIENTS (4) //<! max count of clients of a co_mux_t
+#define CO_RING_SIZE (64)  //<! frames per ring, must be a power of two
+
+/**
+ * @brief Enable/disable setting for the CiA309-3 ASCII gateway.
+ *
+ * With this enabled, command lines of the ASCII protocol as used by CANopen
+ * over Ethernet gateways can be executed with coGatewayRequest(). Parsing is
+ * done in place without any allocation. NMT commands are executed immediately,
+ * SDO reads and writes are pipelined: up to CO_GATEWAY_REQUESTS requests are
+ * in flight, one per node at a time, later requests to a busy node wait for
+ * their turn. Finished requests are collected with coGatewayResponse(). Only
+ * expedited transfers and the data types b, i8, i16, i32, u8, u16 and u32 are
+ * supported. Accepting TCP connections and splitting the stream into lines is
+ * left to the application, e.g. with an epoll loop.
+ */
+// #define CO_GATEWAY_ENABLE
+
+#define CO_GATEWAY_REQUESTS (8) //<! max count of open gateway requests
+
+/**
+ * @brief Enable/disable setting for routing frames to a second bus.
+ *
+ * With this enabled, received frames can be forwarded to another coSimple
+ * instance through co_router_t, e.g. between a legacy and a new bus. Frames
+ * are filtered with a bitmap of the COB-IDs and translated to a new COB-ID
+ * with up to CO_ROUTES routes. Forwarding happens right in the receive path,
+ * the frame is handed to the tx callback of the other bus without queueing.
+ * With CO_MSG_TIMESTAMP_ENABLE the latency from reception to sending is
+ * measured per route. For both directions use one router on each bus.
+ */
+// #define CO_ROUTER_ENABLE
+
+#define CO_ROUTES (16) //<! max count of routes of a co_router_t
+
+/**
+ * @brief Enable/disable setting for replay of recorded bus logs.
+ *
+ * With this enabled, a recorded candump log or Vector ASC log can be fed back
+ * through the receive path of coSimple. The log is parsed lazily one line at a
+ * time straight from the buffer, typically a memory mapped file, so even huge
+ * logs need no further memory. Frames the master sent itself (NMT, SYNC, TIME,
+ * RxPDOs, SDO requests, RTRs) are not replayed but expected to be sent again
+ * and are compared with the frames coSimple sends. Call coReplayRx() and
+ * coReplayTx() from the rx and tx callbacks. Replay runs in original time,
+ * accelerated or as fast as possible. Only frames with 11 bit COB-IDs are used.
+ */
+// #define CO_REPLAY_ENABLE
+
+/**
+ * @brief Enable/disable setting for offline analysis of recorded logs.
+ *
+ * With this enabled, recorded logs can be analyzed with coTraceAnalyze() into
+ * per node statistics: SYNC to TxPDO latency distributions, missed cycles,
+ * SDO round-trip times and EMCYs, as well as frame counts per COB-ID and the
+ * bus load over time. An index of the frames per COB-ID can be built on the
+ * way, to read them again with coLogSeek(). Statistics of several parts of a
+ * log can be merged with coTraceMerge(), so a huge log can be split with
+ * coLogSplit() and analyzed in parallel threads. Requires the log reader of
+ * CO_REPLAY_ENABLE.
+ *
+ * co_trace_t takes about 45 kB, the bus load slots and the index take
+ * memory of the caller, 8 bytes per slot and 16 bytes per frame.
+ */
+// #define CO_TRACE_ENABLE
+
+#define CO_TRACE_BUCKETS (16)   //<! buckets of latency distributions, bucket i counts below 2^i us
+#define CO_TRACE_LOAD_MS (1000) //<! duration in ms of a bus load slot
+
+#if defined(CO_TRACE_ENABLE) && !defined(CO_REPLAY_ENABLE)
+#error "CO_TRACE_ENABLE requires CO_REPLAY_ENABLE"
+#endif
+
+/**
+ * @brief Enable/disable setting for compact binary logging of the bus.
+ *
+ * With this enabled, frames can be recorded with co_blog_t in a compact binary
+ * format: timestamps are delta and varint encoded, COB-IDs are coded through a
+ * dictionary and payloads are XORed against the previous payload of the same
+ * COB-ID, so unchanged bytes of a repeating PDO are left out. Frames are
+ * written in self-contained blocks of CO_BLOG_BLOCK bytes, each with a header
+ * holding the timestamp of its first frame, which makes the log seekable with
+ * coBlogIndex(). The receive path only pushes frames into a lock-free ring,
+ * encoding and writing happens in coBlogWork(). coSimple starts no thread,
+ * running coBlogWork() in a background thread is left to the application.
+ * The binary log is read by coLogNext() just like text logs, so replay and
+ * analysis work on it too. Requires CO_REPLAY_ENABLE and
+ * CO_MSG_TIMESTAMP_ENABLE.
+ */
+// #define CO_BLOG_ENABLE
+
+#define CO_BLOG_BLOCK (4096) //<! size in bytes of a block of the binary log
+#define CO_BLOG_RES_NS (1000) //<! resolution in ns of timestamps in the binary log
+#define CO_BLOG_MAGIC (0x4b424f43) //<! "COBK", start of a block of the binary log
+
+#if defined(CO_BLOG_ENABLE) && (!defined(CO_REPLAY_ENABLE) || !defined(CO_MSG_TIMESTAMP_ENABLE))
+#error "CO_BLOG_ENABLE requires CO_REPLAY_ENABLE and CO_MSG_TIMESTAMP_ENABLE"
+#endif
+
+/**
+ * @brief Enable/disable setting for fault injection into the transport.
+ *
+ * With this enabled, co_fault_t wraps the rx, tx, status and restart callbacks
+ * of the application and injects faults: dropped, delayed (and thereby
+ * reordered), duplicated or corrupted frames and bus-off. Faults are described
+ * by rules that select frames by direction and COB-ID, are active in a time
+ * window and hit with a given probability from a seeded pseudo random
+ * generator. So both random and scripted faults can be reproduced. Wrappers
+ * can be stacked, as they wrap plain callbacks. Recovery from injected bus-off
+ * shows up in co_bus_stats_t with CO_RECOVERY_ENABLE, each rule records when
+ * it hit for the application to relate to its own recovery.
+ */
+// #define CO_FAULT_ENABLE
+
+#define CO_FAULT_DELAYED (8) //<! max count of frames held back at once by delay faults
+
+/**
+ * @brief Enable/disable setting for response-time analysis of the bus.
+ *
+ * With this enabled, coRTA() computes the worst-case response times of a set
+ * of frames, typically the configured PDOs, for a given SYNC period with the
+ * classic CAN schedulability analysis (Tindell, revised by Davis et al. 2007)
+ * including worst-case stuff bits. coRTAMinSyncPeriod() finds the shortest
+ * SYNC period for which all frames meet their deadlines.
+ */
+// #define CO_RTA_ENABLE
+
+/**
+ * @brief Enable/disable setting for redundant operation on two buses.
+ *
+ * With this enabled, co_redundant_t wraps the rx, tx, status and restart
+ * callbacks of two CAN controllers wired to the same nodes. Every frame is
+ * sent on both buses. Received frames are merged: the first copy is passed on
+ * immediately, the copy of the other bus is recognized by COB-ID, data and
+ * order and dropped. Nothing waits for the slower bus, so a dead or slow bus
+ * never adds latency. Copies that don't show up within CO_REDUNDANT_WINDOW_MS
+ * count as lost on that bus. Frames passed on are remembered for another
+ * CO_REDUNDANT_WINDOW_MS, so a copy arriving that late is dropped as well. A
+ * bus-off of one bus is recovered by the wrapper without bothering coSimple,
+ * only if both buses are off it is reported.
+ */
+// #define CO_REDUNDANT_ENABLE
+
+#define CO_REDUNDANT_PENDING (32) //<! max count of frames awaiting their copy from the other bus
+#define CO_REDUNDANT_WINDOW_MS (20) //<! time in ms the copy of a frame is awaited
+
+/**
+ * @brief Enable/disable setting for a hot-standby master.
+ *
+ * With this enabled, coSnapshotSave() serializes the runtime state of coSimple
+ * (SYNC counter, NMT node table, heartbeat producer, guarded nodes, SDO
+ * round-trip time estimates, last broadcast NMT request, additional SDO
+ * channels) together with the process image into a compact snapshot, and coSnapshotLoad() restores it.
+ * coStandbyPublish() replicates the snapshot after every cycle into a
+ * co_standby_t in shared memory, protected with a seqlock like co_shm_t. A
+ * standby process mirrors it with coStandbyFollow() and takes over SYNC
+ * production as soon as the active master stops publishing, without resetting
+ * or reconfiguring the nodes. Registrations that refer to memory of the
+ * application, e.g. hot-plug configurations, are not part of the snapshot, the
+ * standby registers them itself. Background SDO transfers in flight are lost.
+ */
+// #define CO_STANDBY_ENABLE
+
+#define CO_STANDBY_READ_RETRIES (1000) //<! max count of attempts of coStandbyFollow() during a publish
+
+/**
+ * @brief Enable/disable setting for additional SDO channels.
+ *
+ * A node serves one SDO transfer per server channel at a time, so on the
+ * default channel reading a record like 0x1018 costs one round trip per entry.
+ * Many nodes offer additional SDO server channels (0x1201 - 0x127F). With this
+ * enabled coSDOChannelAdd() configures such a channel on a node, with COB-IDs
+ * chosen by the application from 0x680 - 0x6DF, and registers it. coSDOReadParallel() and
+ * coSDOWriteParallel() keep one request in flight on every channel of the
+ * node, and background transfers of coSDOWriteBatchAsync() to the same node
+ * run concurrently, each on its own channel. Channels of a node are forgotten
+ * on its boot-up message, as the node is back at its defaults.
+ */
+// #define CO_SDO_CHANNELS_ENABLE
+
+#define CO_SDO_CHANNELS (8) //<! max count of additional SDO channels over all nodes
+
+/**
+ * @brief Enable/disable setting for program download to many nodes at once.
+ *
+ * With this enabled, co_fw_t downloads one program image to many nodes at
+ * once (CiA302 program download). Each node runs through its own state
+ * machine: software identification 0x1F56 is read and the node is skipped if
+ * it already runs the image. Otherwise, also if the read is aborted, the
+ * program is stopped and cleared with 0x1F51, the image is written to 0x1F50
+ * with SDO block download and the program is started again. The image is only
+ * referenced, not copied, e.g. map the file with mmap(). coFirmwareWork()
+ * sends the sub-blocks of all nodes interleaved, so while one node
+ * acknowledges a sub-block the others keep the bus busy.
+ */
+// #define CO_FIRMWARE_ENABLE
+
+#define CO_FW_TIMEOUT (5000) //<! timeout in ms of a step of a program download, clearing flash is slow
+
+/**
+ * @brief Enable/disable setting for multiplexed PDOs (MPDO).
+ *
+ * A MPDO carries the address of one object together with its value, so an
+ * object is written with one unconfirmed frame instead of a SDO round trip.
+ * coMPDOWrite() sends destination address mode MPDOs, to one node or with
+ * node-id 0 to all nodes at once, e.g. recipe parameters. The nodes need a
+ * RPDO configured as MPDO consumer on the used COB-ID. Source address mode
+ * MPDOs on the COB-IDs registered with coMPDOListen() are matched against the
+ * scanner list co_t.mpdoScan and the object changes forwarded to co_t.mpdo.
+ */
+// #define CO_MPDO_ENABLE
+
+#define CO_MPDO_LISTEN (8) //<! max count of COB-IDs received as source address mode MPDOs
+
+#if defined(CO_SETPOINT_ENABLE) || defined(CO_SHM_ENABLE) || defined(CO_MUX_ENABLE) \
+    || defined(CO_BLOG_ENABLE) || defined(CO_STANDBY_ENABLE)
+#include <stdatomic.h>
+#endif
+
 
 /**
  * @brief Minimal representation of CAN frame
  *
  * identifier format assumed to be standard 11 bit
- * rtr bit always assumed to be 0 = data frame
+ * rtr bit always assumed to be 0 = data frame, except with node guarding
  */
 typedef struct co_msg_s {
     uint16_t cobId;  //<! CAN object identifier, 4 bit op code, 7 bit node-id
     uint8_t len;     //<! length of data
     uint8_t data[8]; //<! CAN frame data
+#ifdef CO_NODE_GUARDING_ENABLE
+    uint8_t rtr; //<! 1 if remote transmission request, 0 in received frames if rx callback doesn't set it
+#endif
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+    uint64_t ts; //<! receive timestamp in ns, 0 if unknown, set by rx callback
+#endif
 } co_msg_t;
 
 /**
  * @brief Callback to be implemented in application to receive raw CAN frames.
  *
  * @note Call must be non-blocking!
+ * @note With CO_MSG_TIMESTAMP_ENABLE also the timestamp has to be set.
+ * @note rtr may be left untouched, coSimple passes a zero-initialized frame.
  *
  * @param[out] msg the received CAN frame
  * @return int -1 on error, 0 on successful reception, 1 on no data
@@ -100,6 +540,20 @@ typedef int (*co_rx_cb_t)(co_msg_t *msg);
  */
 typedef int (*co_tx_cb_t)(const co_msg_t *msg);
 
+/**
+ * @brief Optional callback to be implemented in application to send many raw
+ *        CAN frames at once.
+ *
+ * Allows the transport to hand all frames to the hardware in one go, e.g. by
+ * filling the TX FIFO or mailboxes in a tight loop or with sendmmsg() on
+ * SocketCAN. Frames must be sent in the given order.
+ *
+ * @param[in] msgs the CAN frames to be sent
+ * @param n count of frames in \p msgs
+ * @return int -1 on error, 0 on successful sending of all frames
+ */
+typedef int (*co_tx_batch_cb_t)(const co_msg_t *msgs, size_t n);
+
 /**
  * @brief Callback to be implemented in application to handle EMCY frames.
  *
@@ -125,157 +579,1070 @@ typedef void (*co_emcy_cb_t)(uint8_t nodeId, uint16_t eec, uint8_t er, uint8_t *
 typedef uint32_t (*co_time_cb_t)(void);
 
 /**
- * @brief NMT state change request type
- *
- * @see coNMTReq()
+ * @brief Error state of the CAN controller
  */
-typedef enum co_nmt_state_req_e {
-    CO_NMT_OP = 0x01,     //<! go operational
-    CO_NMT_STOP = 0x02,   //<! stop
-    CO_NMT_PRE_OP = 0x80, //<! go pre-operational
-    CO_NMT_RST = 0x81,    //<! do reset node
-    CO_NMT_RST_COM = 0x82 //<! do reset communication
-} co_nmt_state_req_t;
+typedef enum co_bus_state_e {
+    CO_BUS_ACTIVE = 0,  //<! error active, normal operation
+    CO_BUS_PASSIVE = 1, //<! error passive, an error counter is above 127
+    CO_BUS_OFF = 2      //<! bus-off, controller doesn't take part in communication
+} co_bus_state_t;
 
 /**
- * @brief coSimple instance
+ * @brief Status of the CAN controller
  *
- * Fill struct with all callbacks and use reference to it in API calls.
+ * @see co_status_cb_t
  */
-typedef struct co_s {
-    co_rx_cb_t rx;     //<! application implemented callback to receive CAN frames
-    co_tx_cb_t tx;     //<! application implemented callback to send CAN frames
-    co_emcy_cb_t emcy; //<! application implemented callback to forward EMCY frames
-    co_time_cb_t ms;   //<! application implemented callback to get current time
-#ifdef CO_SYNC_COUNTER_ENABLE
-    uint8_t syncCounter; //<! counter for SYNC service
-#endif
-} co_t;
+typedef struct co_bus_status_s {
+    co_bus_state_t state; //<! error state
+    uint8_t tec;          //<! transmit error counter, saturated at 255
+    uint8_t rec;          //<! receive error counter, saturated at 255
+} co_bus_status_t;
 
 /**
- * @brief Send NMT request to node.
+ * @brief Callback to be implemented in application to get the status of the
+ *        CAN controller.
  *
- * @param[in] co coSimple instance
- * @param nodeId addressed node, range 1 - 127, if = 0 then all nodes
- * @param req the state change request for the node
+ * @param[out] status current status of the controller
  * @return int -1 on error, 0 on success
  */
-int coNMTReq(co_t *co, uint8_t nodeId, co_nmt_state_req_t req);
+typedef int (*co_status_cb_t)(co_bus_status_t *status);
 
 /**
- * @brief Wait until node sends boot-up message.
+ * @brief Callback to be implemented in application to restart the CAN
+ *        controller after bus-off.
  *
- * @warning no timeout implemented!
+ * Should also discard frames that are still queued for transmission, they are
+ * outdated by the time the controller is back.
  *
- * @param[in] co coSimple instance
- * @param nodeId addressed node
  * @return int -1 on error, 0 on success
  */
-int coNMTWaitBoot(co_t *co, uint8_t nodeId);
+typedef int (*co_restart_cb_t)(void);
 
 /**
- * @brief Send SYNC on bus.
+ * @brief Counters of CAN controller error events
  *
- * @param[in] co coSimple instance
- * @return int -1 on error, 0 on success
+ * Maintained by coSimple, may be read or cleared by application.
  */
-int coSYNC(co_t *co);
+typedef struct co_bus_stats_s {
+    uint32_t busOff;         //<! count of bus-off events
+    uint32_t errorPassive;   //<! count of transitions into error passive state
+    uint32_t restarts;       //<! count of controller restarts
+    uint32_t restartErrors;  //<! count of failed controller restarts
+    uint32_t lastRecoveryMs; //<! duration in ms of the last recovery from bus-off
+    uint32_t maxRecoveryMs;  //<! duration in ms of the longest recovery from bus-off
+} co_bus_stats_t;
 
-#ifdef CO_SYNC_COUNTER_ENABLE
 /**
- * @brief Reset internal SYNC counter.
+ * @brief Callback to be implemented in application to get notified about
+ *        finished background SDO transfers.
  *
- * @note This needs to be called once before calling coSYNC the first time and
- *       again after communication has been stopped and started again.
+ * @note Called from within coRPDO() or coSYNC().
  *
- * @param[in] co coSimple instance
- * @return int -1 on error, 0 on success
+ * @param nodeId the node the transfer was for
+ * @param result 0 on success, -1 on error or timeout
  */
-int coSYNCResetCounter(co_t *co);
-#endif
+typedef void (*co_sdo_done_cb_t)(uint8_t nodeId, int result);
 
+#ifdef CO_NODE_GUARDING_ENABLE
 /**
- * @brief Send Timestamp broadcast.
+ * @brief Node guarding event
  *
- * @note Only milliseconds of timestamp is implemented, field for days is set to
- *       zero!
+ * @see co_guard_cb_t
+ */
+typedef enum co_guard_event_e {
+    CO_GUARD_LOST = 0,   //<! node didn't answer within its life time
+    CO_GUARD_TOGGLE = 1, //<! node answered with wrong toggle bit
+    CO_GUARD_RESUMED = 2 //<! node answers again after it was lost
+} co_guard_event_t;
+
+/**
+ * @brief Callback to be implemented in application to handle node guarding
+ *        events.
  *
- * @param[in] co coSimple instance
- * @param ms the milliceconds count to use, if CO_TIME_USE_TIMECB then the
- *           co_time_cb_t time callback is used for the actual value
- * @return int -1 on error, 0 on success
+ * @note Called from within coSYNC() or coRPDO().
+ *
+ * @param nodeId the guarded node
+ * @param event what happened
  */
-int coTIME(co_t *co, uint32_t ms);
+typedef void (*co_guard_cb_t)(uint8_t nodeId, co_guard_event_t event);
+#endif
 
 /**
- * @brief Send PDO to a node.
+ * @brief NMT state change request type
  *
- * @param[in] co coSimple instance
- * @param nodeId addressed node
- * @param[in] data PDO data in network byte order, LSB first!
- * @param len size of data array, range 1 - 8
- * @return int -1 on error, 0 on success
+ * @see coNMTReq()
  */
-int coTPDO(co_t *co, uint8_t nodeId, uint8_t *data, size_t len);
+typedef enum co_nmt_state_req_e {
+    CO_NMT_OP = 0x01,     //<! go operational
+    CO_NMT_STOP = 0x02,   //<! stop
+    CO_NMT_PRE_OP = 0x80, //<! go pre-operational
+    CO_NMT_RST = 0x81,    //<! do reset node
+    CO_NMT_RST_COM = 0x82 //<! do reset communication
+} co_nmt_state_req_t;
 
 /**
- * @brief Receive PDO from a node.
+ * @brief Single SDO write of a node configuration.
  *
- * @note Call is non-blocking! Check return code.
+ * A configuration is an array of these entries and is written in order.
  *
- * @param[in] co coSimple instance
- * @param nodeId addressed node
- * @param[in,out] data PDO data in network byte order, LSB first!
- *                     data array is owned by application
- * @param[out] len size of data array, range 1 - 8
- * @return int -1 on error, 0 on success, 1 on no data
+ * @see coSDOWriteBatch()
+ * @see coSDOConfigure()
  */
-int coRPDO(co_t *co, uint8_t nodeId, uint8_t *data, size_t *len);
+typedef struct co_sdo_cfg_s {
+    uint16_t index;   //<! object dictionary index
+    uint8_t subIndex; //<! od subindex
+    uint8_t len;      //<! size of data, range 1 - 4
+    uint32_t data;    //<! value to be set
+} co_sdo_cfg_t;
 
+#define CO_SDO_CFG_U32(index, subIndex, data) {index, subIndex, sizeof(uint32_t), (uint32_t)data}
+#define CO_SDO_CFG_I32(index, subIndex, data) {index, subIndex, sizeof(int32_t), (uint32_t)data}
+#define CO_SDO_CFG_U16(index, subIndex, data) {index, subIndex, sizeof(uint16_t), (uint32_t)data}
+#define CO_SDO_CFG_I16(index, subIndex, data) {index, subIndex, sizeof(int16_t), (uint32_t)data}
+#define CO_SDO_CFG_U8(index, subIndex, data) {index, subIndex, sizeof(uint8_t), (uint32_t)data}
+#define CO_SDO_CFG_I8(index, subIndex, data) {index, subIndex, sizeof(int8_t), (uint32_t)data}
+
+#ifdef CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
 /**
- * @brief Write value to SDO server.
+ * @brief Round-trip time estimate of SDO transfers
  *
- * @param[in] co coSimple instance
- * @param nodeId addressed node
- * @param index object dictionary index
- * @param subIndex od subindex
- * @param data value to be set
- * @param len size of data in \p data
- * @return uint32_t 0 on success, SDO abort code on error
+ * Fixed point values as in the Jacobson/Karels algorithm. Estimate is only
+ * valid if rttvar is not zero, once valid it never again decays to zero.
  */
-uint32_t coSDOWrite(co_t *co, uint8_t nodeId, uint16_t index, uint8_t subIndex, uint32_t data, size_t len);
+typedef struct co_rtt_s {
+    uint16_t srtt;   //<! smoothed round-trip time in ms, scaled by 8
+    uint16_t rttvar; //<! round-trip time variation in ms, scaled by 4
+} co_rtt_t;
+#endif
 
-#define coSDOWriteU32(co, nodeId, index, subIndex, data) \
-    coSDOWrite(co, nodeId, index, subIndex, (uint32_t)data, sizeof(uint32_t))
-#define coSDOWriteI32(co, nodeId, index, subIndex, data) \
-    coSDOWrite(co, nodeId, index, subIndex, (uint32_t)data, sizeof(int32_t))
-#define coSDOWriteU16(co, nodeId, index, subIndex, data) \
-    coSDOWrite(co, nodeId, index, subIndex, (uint32_t)data, sizeof(uint16_t))
-#define coSDOWriteI16(co, nodeId, index, subIndex, data) \
-    coSDOWrite(co, nodeId, index, subIndex, (uint32_t)data, sizeof(int16_t))
-#define coSDOWriteU8(co, nodeId, index, subIndex, data) \
-    coSDOWrite(co, nodeId, index, subIndex, (uint32_t)data, sizeof(uint8_t))
-#define coSDOWriteI8(co, nodeId, index, subIndex, data) \
-    coSDOWrite(co, nodeId, index, subIndex, (uint32_t)data, sizeof(int8_t))
+#if defined(CO_MSG_TIMESTAMP_ENABLE) || defined(CO_TRACE_ENABLE)
+/**
+ * @brief Latency statistics
+ *
+ * Maintained by coSimple, may be read or cleared by application.
+ */
+typedef struct co_latency_s {
+    uint32_t count; //<! count of measurements
+    uint32_t minNs; //<! smallest latency in ns
+    uint32_t maxNs; //<! largest latency in ns
+    uint64_t sumNs; //<! sum of all latencies in ns, divide by count for mean
+} co_latency_t;
+#endif
 
+#ifdef CO_SDO_CHANNELS_ENABLE
 /**
- * @brief Read value from SDO server.
+ * @brief SDO channel of a node
+ */
+typedef struct co_sdo_channel_s {
+    uint16_t request;  //<! COB-ID of requests, client to server
+    uint16_t response; //<! COB-ID of responses, server to client
+    uint8_t nodeId;    //<! node serving the channel, 0 if unused
+} co_sdo_channel_t;
+#endif
+
+#ifdef CO_SDO_ASYNC_ENABLE
+/**
+ * @brief Background SDO transfer
  *
- * @param[in] co coSimple instance
- * @param nodeId addressed node
- * @param index object dictionary index
- * @param subIndex od subindex
- * @param[out] data read value
- * @param len size of data in \p data
- * @return uint32_t 0 on success, SDO abort code on error
+ * Internal state, is not to be modified by application.
  */
-uint32_t coSDORead(co_t *co, uint8_t nodeId, uint16_t index, uint8_t subIndex, uint32_t *data, size_t len);
+typedef struct co_sdo_job_s {
+    const co_sdo_cfg_t *cfg; //<! configuration to write, NULL if job is unused
+    size_t n;                //<! count of entries in cfg
+    size_t pos;              //<! entry that is currently transferred
+    uint32_t start;          //<! time in ms the current request was sent
+    uint32_t timeout;        //<! timeout in ms of the current request
+    uint8_t attempt;         //<! count of repetitions of the current request
+    uint8_t nodeId;          //<! addressed node
+#ifdef CO_HOTPLUG_ENABLE
+    uint8_t hotplug; //<! set node operational after the transfer
+#endif
+#ifdef CO_SDO_CHANNELS_ENABLE
+    co_sdo_channel_t channel; //<! channel the transfer runs on
+#endif
+} co_sdo_job_t;
+#endif
 
-#define coSDOReadU32(co, nodeId, index, subIndex, data) \
-    coSDORead(co, nodeId, index, subIndex, (uint32_t *)data, sizeof(uint32_t))
-#define coSDOReadI32(co, nodeId, index, subIndex, data) \
-    coSDORead(co, nodeId, index, subIndex, (uint32_t *)data, sizeof(int32_t))
-#define coSDOReadU16(co, nodeId, index, subIndex, data) \
+#ifdef CO_HOTPLUG_ENABLE
+/**
+ * @brief Configuration of a node registered for hot-plug
+ */
+typedef struct co_hotplug_s {
+    const co_sdo_cfg_t *cfg; //<! configuration to replay on boot-up
+    size_t n;                //<! count of entries in cfg
+    uint8_t nodeId;          //<! registered node, 0 if unused
+} co_hotplug_t;
+#endif
+
+#ifdef CO_NMT_TABLE_ENABLE
+/**
+ * @brief NMT state as reported by a node
+ *
+ * @see coNMTState()
+ */
+typedef enum co_nmt_state_e {
+    CO_NMT_STATE_BOOT = 0x00,    //<! boot-up
+    CO_NMT_STATE_STOPPED = 0x04, //<! stopped
+    CO_NMT_STATE_OP = 0x05,      //<! operational
+    CO_NMT_STATE_PRE_OP = 0x7f,  //<! pre-operational
+    CO_NMT_STATE_UNKNOWN = 0xff  //<! node not seen yet
+} co_nmt_state_t;
+
+/**
+ * @brief Entry of NMT node state table
+ *
+ * Maintained by coSimple, may be read by application.
+ */
+typedef struct co_node_s {
+    uint32_t lastSeen; //<! time in ms of last heartbeat or boot-up
+    uint8_t state;     //<! last reported co_nmt_state_t
+    uint8_t bootCount; //<! count of received boot-up messages, wraps around
+    uint8_t seen;      //<! node has been seen at least once
+} co_node_t;
+#endif
+
+#ifdef CO_NODE_GUARDING_ENABLE
+/**
+ * @brief Node guarding state of a node
+ *
+ * Internal state, is not to be modified by application.
+ */
+typedef struct co_guard_s {
+    uint32_t lastRequest;   //<! time in ms the last RTR was sent
+    uint32_t lastResponse;  //<! time in ms of the last valid answer
+    uint16_t guardTime;     //<! time in ms between RTRs
+    uint8_t lifeTimeFactor; //<! node is lost after guardTime * lifeTimeFactor without answer
+    uint8_t toggle;         //<! expected toggle bit of the next answer
+    uint8_t lost;           //<! node is considered lost
+    uint8_t nodeId;         //<! guarded node, 0 if unused
+} co_guard_t;
+#endif
+
+#if defined(CO_MUX_ENABLE) || defined(CO_BLOG_ENABLE)
+/**
+ * @brief Lock-free frame ring for a single producer and a single consumer
+ */
+typedef struct co_ring_s {
+    atomic_uint head;            //<! next write position, only written by producer
+    atomic_uint tail;            //<! next read position, only written by consumer
+    co_msg_t msgs[CO_RING_SIZE]; //<! buffered frames
+} co_ring_t;
+#endif
+
+#ifdef CO_MUX_ENABLE
+
+/**
+ * @brief Client of a bus-sharing daemon, to be placed in shared memory
+ */
+typedef struct co_mux_client_s {
+    co_ring_t rx;       //<! frames from the bus to the client
+    co_ring_t tx;       //<! frames from the client to the bus
+    atomic_uint active; //<! set by the client while it is attached
+    uint32_t dropped;   //<! count of frames dropped because rx ring was full
+} co_mux_client_t;
+
+/**
+ * @brief Bus-sharing daemon, lives in the process that owns the bus
+ */
+typedef struct co_mux_s {
+    co_mux_client_t *clients[CO_MUX_CLIENTS]; //<! attached clients, NULL if unused
+    uint32_t sdoSince[127];                  //<! time in ms of last SDO request per node
+    uint8_t sdoOwner[127];                   //<! client index + 1 owning the SDO channel, 0 if free
+    uint8_t sdoRequest[127];                 //<! command byte of the last SDO request per node
+} co_mux_t;
+#endif
+
+#ifdef CO_ROUTER_ENABLE
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+/**
+ * @brief Callback to be implemented in application to get current time in ns.
+ *
+ * @note Must use the same clock as the receive timestamps of co_msg_t.
+ *
+ * @return uint64_t current time in ns
+ */
+typedef uint64_t (*co_ns_cb_t)(void);
+#endif
+
+/**
+ * @brief Route of a COB-ID to another bus
+ */
+typedef struct co_route_s {
+    uint16_t from;      //<! received COB-ID
+    uint16_t to;        //<! COB-ID on the other bus
+    uint32_t forwarded; //<! count of forwarded frames
+    uint32_t errors;    //<! count of frames the other bus failed to send
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+    co_latency_t latency; //<! latency from reception to sending
+#endif
+} co_route_t;
+
+/**
+ * @brief Router of frames from one bus to another
+ *
+ * Set co_t::router of the receiving bus to it.
+ */
+typedef struct co_router_s {
+    struct co_s *to; //<! coSimple instance of the other bus
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+    co_ns_cb_t ns; //<! optional clock for latency measurement
+#endif
+    uint32_t filter[2048 / 32];   //<! bitmap of COB-IDs with a route
+    co_route_t routes[CO_ROUTES]; //<! routes, the first n are used
+    size_t n;                     //<! count of used routes
+} co_router_t;
+#endif
+
+#ifdef CO_REPLAY_ENABLE
+/**
+ * @brief Reader of a candump or ASC log in memory
+ */
+typedef struct co_log_s {
+    const char *data; //<! the log, needs no termination
+    size_t len;       //<! size of the log
+    size_t pos;       //<! read position, start of the next line
+    size_t framePos;  //<! position to read the last returned frame again from, its block in a binary log
+    uint32_t line;    //<! line number of the last returned frame, starting at 1
+    uint32_t lines;   //<! count of lines read
+    uint32_t skipped; //<! count of lines that were no usable frame
+#ifdef CO_BLOG_ENABLE
+    uint8_t binary;        //<! log is a binary log, detected on first read
+    size_t blockEnd;       //<! end of the current block of a binary log
+    uint64_t ts;           //<! timestamp in ns of the last frame of a binary log
+    uint32_t res;          //<! timestamp resolution in ns of the current block
+    uint8_t dictLen;       //<! count of COB-IDs in the dictionary
+    uint16_t dict[127];    //<! COB-IDs of the current block
+    uint8_t prevLen[127];  //<! length of the previous payload per dictionary entry
+    uint8_t prev[127][8];  //<! previous payload per dictionary entry
+#endif
+} co_log_t;
+
+/**
+ * @brief Replay of a log, compares sent frames with the recording
+ */
+typedef struct co_replay_s {
+    co_log_t rx;            //<! cursor of the frames to replay
+    co_log_t tx;            //<! cursor of the frames the master is expected to send
+    co_time_cb_t ms;        //<! clock for pacing, NULL to replay as fast as possible
+    uint32_t speed;         //<! acceleration, 1 for original time
+    uint32_t startMs;       //<! time in ms the first frame was replayed
+    uint64_t startTs;       //<! log timestamp in ns of the first frame
+    co_msg_t next;          //<! next frame, parsed but not yet due
+    uint64_t nextTs;        //<! log timestamp in ns of next
+    uint8_t pending;        //<! next is valid
+    uint8_t started;        //<! first frame was replayed
+    uint32_t matched;       //<! count of sent frames equal to the recording
+    uint32_t mismatched;    //<! count of sent frames different from the recording
+    uint32_t unexpected;    //<! count of sent frames after the recording ended
+    uint32_t missing;       //<! count of recorded frames that were not sent
+    uint32_t firstMismatch; //<! line number of the first mismatch, 0 if none
+} co_replay_t;
+#endif
+
+#ifdef CO_TRACE_ENABLE
+/**
+ * @brief Callback to be implemented in application to get every EMCY of a log.
+ *
+ * @param nodeId node that sent the EMCY
+ * @param eec emergency error code
+ * @param er error register
+ * @param ts timestamp of the EMCY in ns
+ */
+typedef void (*co_trace_emcy_cb_t)(uint8_t nodeId, uint16_t eec, uint8_t er, uint64_t ts);
+
+/**
+ * @brief Statistics of a node in a log
+ */
+typedef struct co_trace_node_s {
+    co_latency_t pdoLatency;            //<! SYNC to TxPDO latency
+    uint32_t pdoHist[CO_TRACE_BUCKETS]; //<! distribution of pdoLatency, last bucket counts larger too
+    uint32_t missed;                    //<! count of SYNC cycles without TxPDO, once the node sent one
+    co_latency_t sdoRtt;                //<! SDO request to response time
+    uint32_t emcyCount;                 //<! count of EMCYs
+    uint16_t emcyLast;                  //<! last emergency error code
+    uint64_t emcyFirstTs;               //<! timestamp in ns of the first EMCY
+    uint64_t emcyLastTs;                //<! timestamp in ns of the last EMCY
+} co_trace_node_t;
+
+/**
+ * @brief Entry of the COB-ID index of a log, one per frame
+ */
+typedef struct co_trace_ref_s {
+    size_t pos;    //<! position to read the frame from with coLogSeek(), its block in a binary log
+    uint32_t next; //<! number of the next frame with the same COB-ID, 0 if none
+} co_trace_ref_t;
+
+/**
+ * @brief Statistics of a log
+ *
+ * Initialize to zero, start may be set to the timestamp of the first frame
+ * of the whole log so that parts analyzed in parallel share the load slots.
+ * The memory for the bus load and the COB-ID index is provided by the
+ * caller, sized to the log, e.g. 86400 slots of 1 s for a day.
+ *
+ * Frames are numbered from 1 in the order of the log. The frames of a
+ * COB-ID are found by following co_trace_ref_t::next from head.
+ */
+typedef struct co_trace_s {
+    uint64_t start;             //<! timestamp in ns of load slot 0, 0 to take the first frame
+    uint64_t first;             //<! timestamp in ns of the first frame
+    uint64_t last;              //<! timestamp in ns of the last frame
+    uint64_t count;             //<! count of frames
+    uint32_t syncs;             //<! count of SYNCs
+    co_trace_emcy_cb_t emcy;    //<! optional callback for every EMCY, e.g. to print a timeline
+    uint32_t frames[2048];      //<! count of frames per COB-ID
+    uint64_t *loadBits;         //<! optional bits per slot of CO_TRACE_LOAD_MS, without stuff bits
+    size_t loadSlots;           //<! count of entries of loadBits, later frames are not accounted
+    co_trace_ref_t *refs;       //<! optional COB-ID index, entry i is frame i + 1
+    size_t refsLen;             //<! count of entries of refs, once full further frames are not indexed
+    size_t base;                //<! position of the analyzed part in the whole log, added to index
+    uint32_t indexed;           //<! count of frames in refs
+    uint32_t head[2048];        //<! number of the first frame per COB-ID, 0 if none
+    uint32_t tail[2048];        //<! number of the last frame per COB-ID, 0 if none
+    co_trace_node_t nodes[127]; //<! statistics per node, index is nodeId - 1
+    uint64_t syncTs;            //<! internal, timestamp of the last SYNC
+    uint64_t syncPeriod;        //<! internal, time in ns between the last two SYNCs
+    uint64_t sdoTs[127];        //<! internal, timestamp of the open SDO request per node
+    uint32_t active[4];         //<! internal, nodes that sent a TxPDO
+    uint32_t seen[4];           //<! internal, nodes that sent a TxPDO in the current cycle
+} co_trace_t;
+#endif
+
+#ifdef CO_BLOG_ENABLE
+/**
+ * @brief Callback to be implemented in application to store a finished block.
+ *
+ * @param[in] block the block
+ * @param len size of the block
+ * @return int -1 on error, 0 on success
+ */
+typedef int (*co_blog_write_cb_t)(const void *block, size_t len);
+
+/**
+ * @brief Writer of a binary log
+ *
+ * Set co_t::blog to it to record all received frames, frames sent by the
+ * master can be recorded with coBlogRecord() in the tx callback.
+ */
+typedef struct co_blog_s {
+    co_blog_write_cb_t write;     //<! application implemented callback to store finished blocks
+    co_ring_t ring;               //<! frames recorded but not yet encoded
+    uint32_t dropped;             //<! count of frames dropped because ring was full
+    uint32_t errors;              //<! count of blocks the write callback failed to store
+    uint8_t block[CO_BLOG_BLOCK]; //<! block being filled
+    size_t used;                  //<! used bytes of block, 0 if block is empty
+    uint32_t frames;              //<! count of frames in block
+    uint64_t ts;                  //<! timestamp in units of CO_BLOG_RES_NS of the last frame in block
+    uint8_t dictLen;              //<! count of COB-IDs in the dictionary
+    uint16_t dict[127];           //<! COB-IDs of the block
+    uint8_t prevLen[127];         //<! length of the previous payload per dictionary entry
+    uint8_t prev[127][8];         //<! previous payload per dictionary entry
+} co_blog_t;
+#endif
+
+#ifdef CO_FAULT_ENABLE
+/**
+ * @brief Kind of injected fault
+ */
+typedef enum co_fault_type_e {
+    CO_FAULT_DROP,    //<! frame is lost
+    CO_FAULT_DELAY,   //<! frame is held back for param ms, overtaken by later frames
+    CO_FAULT_DUP,     //<! frame is passed twice
+    CO_FAULT_CORRUPT, //<! a random bit of COB-ID or data is flipped
+    CO_FAULT_BUS_OFF  //<! controller goes bus-off until restarted, only on tx
+} co_fault_type_t;
+
+#define CO_FAULT_RX (0x01)        //<! rule applies to received frames
+#define CO_FAULT_TX (0x02)        //<! rule applies to sent frames
+#define CO_FAULT_ALWAYS (0x10000) //<! chance of a rule that hits every frame
+
+/**
+ * @brief Rule for fault injection
+ */
+typedef struct co_fault_rule_s {
+    co_fault_type_t type; //<! kind of fault
+    uint8_t dir;          //<! CO_FAULT_RX and/or CO_FAULT_TX
+    uint16_t cobId;       //<! affected COB-ID, after applying mask
+    uint16_t mask;        //<! mask for COB-IDs, 0 affects all frames
+    uint32_t chance;      //<! probability per frame in 1/65536, CO_FAULT_ALWAYS for every frame
+    uint32_t from;        //<! start of active window in ms after coFaultInit()
+    uint32_t to;          //<! end of active window in ms after coFaultInit(), 0 for no end
+    uint32_t param;       //<! delay in ms for CO_FAULT_DELAY
+    uint32_t hits;        //<! count of injected faults
+    uint32_t firstHit;    //<! time in ms of the first injected fault
+    uint32_t lastHit;     //<! time in ms of the last injected fault
+} co_fault_rule_t;
+
+/**
+ * @brief Frame held back by a delay fault
+ *
+ * Internal state, is not to be modified by application.
+ */
+typedef struct co_fault_delayed_s {
+    co_msg_t msg; //<! the frame
+    uint32_t due; //<! time in ms the frame is passed on
+    uint8_t dir;  //<! CO_FAULT_RX or CO_FAULT_TX, 0 if unused
+} co_fault_delayed_t;
+
+/**
+ * @brief Fault injecting wrapper of the transport callbacks
+ *
+ * Fill in the wrapped callbacks and rules, then call coFaultInit().
+ */
+typedef struct co_fault_s {
+    co_rx_cb_t rx;                                //<! wrapped callback to receive CAN frames
+    co_tx_cb_t tx;                                //<! wrapped callback to send CAN frames
+    co_time_cb_t ms;                              //<! callback to get current time
+    co_status_cb_t status;                        //<! optional wrapped callback to get controller status
+    co_restart_cb_t restart;                      //<! optional wrapped callback to restart controller
+    co_fault_rule_t *rules;                       //<! array of rules
+    size_t n;                                     //<! count of rules
+    uint32_t seed;                                //<! seed of the pseudo random generator
+    uint32_t state;                               //<! state of the pseudo random generator
+    uint32_t start;                               //<! time in ms of coFaultInit()
+    uint8_t busOff;                               //<! injected bus-off is active
+    co_fault_delayed_t delayed[CO_FAULT_DELAYED]; //<! frames held back
+} co_fault_t;
+#endif
+
+#ifdef CO_RTA_ENABLE
+/**
+ * @brief Frame for response-time analysis
+ */
+typedef struct co_rta_frame_s {
+    uint16_t cobId;      //<! COB-ID, lower wins the arbitration
+    uint8_t len;         //<! size of data, range 0 - 8
+    uint32_t periodUs;   //<! min time in us between two frames, 0 for once per SYNC period
+    uint32_t jitterUs;   //<! max delay in us from the event until the frame is queued
+    uint32_t deadlineUs; //<! deadline in us after the event, 0 for periodUs or the SYNC period
+    uint32_t responseUs; //<! result: worst-case response time in us, UINT32_MAX if unbounded
+} co_rta_frame_t;
+#endif
+
+#ifdef CO_REDUNDANT_ENABLE
+/**
+ * @brief One bus of redundant operation
+ */
+typedef struct co_redundant_bus_s {
+    co_rx_cb_t rx;           //<! wrapped callback to receive CAN frames
+    co_tx_cb_t tx;           //<! wrapped callback to send CAN frames
+    co_status_cb_t status;   //<! optional wrapped callback to get controller status
+    co_restart_cb_t restart; //<! optional wrapped callback to restart controller
+    uint32_t received;       //<! count of received frames
+    uint32_t first;          //<! count of received frames that were passed on, i.e. arrived first
+    uint32_t lost;           //<! count of frames only received on the other bus
+    uint32_t late;           //<! count of copies dropped after CO_REDUNDANT_WINDOW_MS, not in lost
+    uint32_t rxErrors;       //<! count of failed receptions
+    uint32_t txErrors;       //<! count of failed sendings
+    uint32_t restarts;       //<! count of restarts after a bus-off of only this bus
+    uint32_t lastRx;         //<! time in ms of the last received frame
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+    co_latency_t lag; //<! delay of received frames behind the first copy, 0 if first
+#endif
+} co_redundant_bus_t;
+
+/**
+ * @brief Frame awaiting its copy from the other bus
+ *
+ * Internal state, is not to be modified by application.
+ */
+typedef struct co_redundant_pending_s {
+    co_msg_t msg;  //<! the frame
+    uint32_t time; //<! time in ms the frame was received
+    uint8_t bus;   //<! 1 or 2 for the bus that received it, 0 if unused
+} co_redundant_pending_t;
+
+/**
+ * @brief Redundant wrapper of the transport callbacks of two buses
+ *
+ * Fill in the wrapped callbacks of both buses, then call coRedundantInit().
+ */
+typedef struct co_redundant_s {
+    co_redundant_bus_t bus[2];                             //<! the buses
+    co_time_cb_t ms;                                       //<! callback to get current time
+    uint8_t next;                                          //<! bus to poll first with the next reception
+    co_redundant_pending_t pending[CO_REDUNDANT_PENDING]; //<! frames awaiting their copy
+    co_redundant_pending_t overdue[CO_REDUNDANT_PENDING]; //<! frames whose copy is overdue, to drop it late
+} co_redundant_t;
+#endif
+
+#ifdef CO_STANDBY_ENABLE
+#define CO_STANDBY_MAGIC (0x636f5342)  //<! "coSB", identifies a co_standby_t
+#define CO_SNAPSHOT_MAGIC (0x636f534e) //<! "coSN", start of a snapshot
+#define CO_SNAPSHOT_LAYOUT (3)         //<! layout version of snapshots
+
+/**
+ * @brief Snapshot replicated to a standby master in shared memory
+ *
+ * Sequence is odd while the active master updates the snapshot, every publish
+ * increments it by two.
+ */
+typedef struct co_standby_s {
+    uint32_t magic;  //<! CO_STANDBY_MAGIC once initialized
+    atomic_uint seq; //<! seqlock sequence
+    uint32_t size;   //<! capacity in bytes of data
+    uint32_t len;    //<! size in bytes of the current snapshot
+    uint8_t data[];  //<! snapshot, see coSnapshotSave()
+} co_standby_t;
+#endif
+
+#ifdef CO_FIRMWARE_ENABLE
+/**
+ * @brief Step of a program download to a node
+ */
+typedef enum co_fw_state_e {
+    CO_FW_IDENT,   //<! reading software identification
+    CO_FW_STOP,    //<! stopping program
+    CO_FW_CLEAR,   //<! clearing program
+    CO_FW_INIT,    //<! initiating block download
+    CO_FW_BLOCK,   //<! sending a sub-block
+    CO_FW_ACK,     //<! waiting for acknowledge of a sub-block
+    CO_FW_END,     //<! ending block download
+    CO_FW_START,   //<! starting program
+    CO_FW_DONE,    //<! finished, program runs
+    CO_FW_SKIPPED, //<! finished, node already runs the program
+    CO_FW_FAILED   //<! finished with error, see abort code
+} co_fw_state_t;
+
+/**
+ * @brief Program download to one node
+ *
+ * Set nodeId, everything else is maintained by coSimple.
+ */
+typedef struct co_fw_node_s {
+    uint8_t nodeId;      //<! node to update
+    co_fw_state_t state; //<! current step
+    uint32_t abort;      //<! SDO abort code if failed
+    uint32_t start;      //<! time in ms of the last request or acknowledge
+    size_t pos;          //<! count of bytes acknowledged by the node
+    uint8_t seq;         //<! count of segments sent of the current sub-block
+    uint8_t blksize;     //<! count of segments of the current sub-block
+    uint8_t crc;         //<! node checks the CRC of the image
+    uint8_t request;     //<! request of the current step is still to be sent
+} co_fw_node_t;
+
+/**
+ * @brief Program download to many nodes
+ *
+ * Fill in image, ident and nodes, then call coFirmwareStart().
+ */
+typedef struct co_fw_s {
+    const uint8_t *image; //<! program image, must stay valid until finished
+    size_t len;           //<! size in bytes of the image
+    uint32_t ident;       //<! software identification of the image, 0 to always download
+    uint8_t program;      //<! program number, subindex of 0x1F50, 0x1F51 and 0x1F56, 1 if only one
+    co_fw_node_t *nodes;  //<! nodes to update
+    size_t n;             //<! count of nodes
+    uint16_t crc;         //<! CRC of the image
+    size_t next;          //<! node to send the next segment of
+} co_fw_t;
+#endif
+
+#ifdef CO_MPDO_ENABLE
+/**
+ * @brief Application callback for an object change received by MPDO
+ *
+ * @param nodeId the producing node
+ * @param index object dictionary index on the producing node
+ * @param subIndex od subindex
+ * @param data value, little endian of up to 4 bytes
+ */
+typedef void (*co_mpdo_cb_t)(uint8_t nodeId, uint16_t index, uint8_t subIndex, uint32_t data);
+
+/**
+ * @brief Entry of the MPDO scanner list, objects to receive
+ */
+typedef struct co_mpdo_scan_s {
+    uint8_t nodeId;   //<! producing node, 0 for all nodes
+    uint16_t index;   //<! object dictionary index
+    uint8_t subIndex; //<! first od subindex
+    uint8_t count;    //<! count of subindices from subIndex on
+} co_mpdo_scan_t;
+#endif
+
+#ifdef CO_GATEWAY_ENABLE
+/**
+ * @brief Operation of a gateway command
+ */
+typedef enum co_gw_op_e {
+    CO_GW_READ,  //<! SDO upload
+    CO_GW_WRITE, //<! SDO download
+    CO_GW_NMT    //<! NMT state change request
+} co_gw_op_t;
+
+/**
+ * @brief Parsed gateway command line
+ */
+typedef struct co_gw_cmd_s {
+    uint32_t seq;           //<! sequence number, echoed in the response
+    co_gw_op_t op;          //<! requested operation
+    uint8_t nodeId;         //<! addressed node, 0 for all nodes with NMT
+    co_nmt_state_req_t nmt; //<! NMT request, only with CO_GW_NMT
+    uint16_t index;         //<! object dictionary index
+    uint8_t subIndex;       //<! od subindex
+    uint8_t len;            //<! size of data type, range 1 - 4
+    uint8_t isSigned;       //<! data type is signed
+    uint32_t data;          //<! value to write or read value
+} co_gw_cmd_t;
+
+/**
+ * @brief Open gateway request
+ *
+ * Internal state, is not to be modified by application.
+ */
+typedef struct co_gw_req_s {
+    co_gw_cmd_t cmd;  //<! the command
+    void *ctx;        //<! application context, e.g. the connection
+    uint32_t start;   //<! time in ms the request was sent
+    uint32_t timeout; //<! current response timeout in ms
+    uint32_t abort;   //<! 0 on success, SDO abort code on error
+    uint8_t attempt;  //<! count of repeated requests
+    uint8_t state;    //<! 0 free, 1 waiting for node, 2 in flight, 3 done
+    uint8_t discard;  //<! context is gone, drop response
+} co_gw_req_t;
+#endif
+
+/**
+ * @brief coSimple instance
+ *
+ * Fill struct with all callbacks and use reference to it in API calls.
+ */
+typedef struct co_s {
+    co_rx_cb_t rx;            //<! application implemented callback to receive CAN frames
+    co_tx_cb_t tx;            //<! application implemented callback to send CAN frames
+    co_emcy_cb_t emcy;        //<! application implemented callback to forward EMCY frames
+    co_time_cb_t ms;          //<! application implemented callback to get current time
+    co_tx_batch_cb_t txBatch; //<! optional application implemented callback to send many CAN frames
+#ifdef CO_SYNC_COUNTER_ENABLE
+    uint8_t syncCounter; //<! counter for SYNC service
+#endif
+#ifdef CO_MSG_TIMESTAMP_ENABLE
+    uint64_t pdoTs[127];     //<! receive timestamp of the last PDO of coRPDO(), index is nodeId - 1
+    uint64_t syncTs;         //<! receive timestamp of the last SYNC seen in loopback
+    co_latency_t pdoLatency; //<! latency of TxPDOs to the preceding SYNC
+#endif
+#ifdef CO_NMT_TABLE_ENABLE
+    co_node_t nodes[127]; //<! NMT state table, index is nodeId - 1
+#endif
+#if defined(CO_HEARTBEAT_ENABLE) || defined(CO_NODE_GUARDING_ENABLE)
+    uint32_t timerNext; //<! time in ms of the next heartbeat or guarding deadline
+#endif
+#ifdef CO_HEARTBEAT_ENABLE
+    uint16_t hbPeriod; //<! master heartbeat period in ms, 0 if disabled
+    uint8_t hbNodeId;  //<! node-id of the master for its heartbeat
+    uint32_t hbLast;   //<! time in ms the last heartbeat was sent
+#endif
+#ifdef CO_NODE_GUARDING_ENABLE
+    co_guard_cb_t guard;               //<! application implemented callback for node guarding events
+    co_guard_t guards[CO_GUARD_NODES]; //<! guarded nodes
+#endif
+#ifdef CO_SDO_ADAPTIVE_TIMEOUT_ENABLE
+    co_rtt_t rtt[127]; //<! SDO round-trip time estimate per node, index is nodeId - 1
+    co_rtt_t rttBus;   //<! SDO round-trip time estimate over all nodes
+#endif
+#ifdef CO_SDO_ASYNC_ENABLE
+    co_sdo_done_cb_t sdoDone;                //<! optional application callback for finished transfers
+    co_sdo_job_t sdoJobs[CO_SDO_ASYNC_JOBS]; //<! background SDO transfers
+#endif
+#if defined(CO_SDO_ASYNC_ENABLE) || defined(CO_GATEWAY_ENABLE)
+    uint8_t sdoNode; //<! node of the blocking SDO transfer in progress, 0 if none
+#endif
+#ifdef CO_SDO_CHANNELS_ENABLE
+    co_sdo_channel_t sdoChannels[CO_SDO_CHANNELS]; //<! additional SDO channels
+#endif
+#ifdef CO_HOTPLUG_ENABLE
+    co_hotplug_t hotplug[CO_HOTPLUG_NODES]; //<! nodes registered for hot-plug
+#endif
+#ifdef CO_MPDO_ENABLE
+    co_mpdo_cb_t mpdo;                   //<! optional application callback for objects received by MPDO
+    const co_mpdo_scan_t *mpdoScan;      //<! optional scanner list, NULL to receive all objects
+    size_t mpdoScanN;                    //<! count of entries in mpdoScan
+    uint16_t mpdoListen[CO_MPDO_LISTEN]; //<! COB-IDs received as MPDOs, 0 if unused
+#endif
+#ifdef CO_MUX_ENABLE
+    co_mux_t *mux; //<! optional bus-sharing daemon to forward received frames to
+#endif
+#ifdef CO_ROUTER_ENABLE
+    co_router_t *router; //<! optional router to forward received frames to another bus
+#endif
+#ifdef CO_BLOG_ENABLE
+    co_blog_t *blog; //<! optional binary log to record received frames in
+#endif
+#ifdef CO_GATEWAY_ENABLE
+    co_gw_req_t gwReqs[CO_GATEWAY_REQUESTS]; //<! open gateway requests, in order of arrival
+#endif
+#ifdef CO_STANDBY_ENABLE
+    uint32_t standbyVersion; //<! last followed snapshot of the active master
+    uint32_t standbyChanged; //<! time in ms the followed snapshot last changed
+#endif
+#ifdef CO_RECOVERY_ENABLE
+    co_status_cb_t status;   //<! application implemented callback to get CAN controller status
+    co_restart_cb_t restart; //<! application implemented callback to restart CAN controller
+    co_bus_stats_t busStats; //<! error event counters
+    co_bus_state_t busState; //<! last known CAN controller error state
+    uint32_t busOffSince;    //<! time in ms when bus-off was detected
+    uint32_t busRestartAt;   //<! time in ms of the last controller restart
+    uint8_t busResync;       //<! nodes are still to be resynchronized after a bus-off
+    uint8_t nmtLast;         //<! last broadcast NMT request, 0 if none
+    uint8_t nmtNodes[127];   //<! later NMT requests to single nodes, 0 if none, index is nodeId - 1
+#endif
+} co_t;
+
+/**
+ * @brief Send NMT request to node.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node, range 1 - 127, if = 0 then all nodes
+ * @param req the state change request for the node
+ * @return int -1 on error, 0 on success
+ */
+int coNMTReq(co_t *co, uint8_t nodeId, co_nmt_state_req_t req);
+
+/**
+ * @brief Wait until node sends boot-up message.
+ *
+ * @warning no timeout implemented!
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @return int -1 on error, 0 on success
+ */
+int coNMTWaitBoot(co_t *co, uint8_t nodeId);
+
+#ifdef CO_NMT_TABLE_ENABLE
+/**
+ * @brief Get the last reported NMT state of a node.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @return co_nmt_state_t last reported state, CO_NMT_STATE_UNKNOWN if not seen
+ */
+co_nmt_state_t coNMTState(co_t *co, uint8_t nodeId);
+
+/**
+ * @brief Send NMT request to node and wait until it reports the new state.
+ *
+ * Waits for a heartbeat with the requested state that is received after the
+ * request was sent. For the reset requests it waits for a boot-up message.
+ * Frames are received from the rx callback, but the table may as well be
+ * updated concurrently from an interrupt calling coRPDO().
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node, range 1 - 127
+ * @param req the state change request for the node
+ * @param timeout max time in ms to wait for the confirmation
+ * @return int -1 on error or timeout, 0 on success
+ */
+int coNMTReqConfirm(co_t *co, uint8_t nodeId, co_nmt_state_req_t req, uint32_t timeout);
+
+/**
+ * @brief Set of nodes, one bit per nodeId
+ *
+ * Bit n of word n / 32 represents node n, bit 0 is unused.
+ */
+typedef struct co_node_set_s {
+    uint32_t bits[4]; //<! bitmap of nodes
+} co_node_set_t;
+
+#define CO_NODE_SET_ADD(set, nodeId) ((set)->bits[(nodeId) >> 5] |= (1UL << ((nodeId) & 31)))
+#define CO_NODE_SET_DEL(set, nodeId) ((set)->bits[(nodeId) >> 5] &= ~(1UL << ((nodeId) & 31)))
+#define CO_NODE_SET_HAS(set, nodeId) (0 != ((set)->bits[(nodeId) >> 5] & (1UL << ((nodeId) & 31))))
+
+/**
+ * @brief Send NMT request to many nodes and wait until they report the new
+ *        state.
+ *
+ * A single broadcast is sent if all nodes are targeted, or if \p broadcast is
+ * set and the targets include every node that was seen so far. Otherwise one
+ * request per target is sent. Then it waits until every target reported the
+ * requested state (same as coNMTReqConfirm()) or the timeout expires. Nodes
+ * that didn't confirm in time are returned in \p stragglers, which can
+ * directly be used as targets for a retry.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] targets nodes to send request to
+ * @param req the state change request for the nodes
+ * @param timeout max time in ms to wait for all confirmations
+ * @param broadcast 1 to allow a broadcast if no node outside the targets was
+ *                  seen, also hits nodes without heartbeat, 0 to not allow it
+ * @param[out] stragglers nodes that didn't confirm, may be same as \p targets
+ * @return int -1 on error, count of stragglers otherwise, 0 if all confirmed
+ */
+int coNMTReqBulk(co_t *co, const co_node_set_t *targets, co_nmt_state_req_t req, uint32_t timeout,
+                 int broadcast, co_node_set_t *stragglers);
+#endif
+
+/**
+ * @brief Send SYNC on bus.
+ *
+ * @param[in] co coSimple instance
+ * @return int -1 on error, 0 on success
+ */
+int coSYNC(co_t *co);
+
+#ifdef CO_HEARTBEAT_ENABLE
+/**
+ * @brief Start or stop the master heartbeat.
+ *
+ * Heartbeats are sent by coSYNC() as soon as the period elapsed, so the
+ * effective period is rounded up to the next SYNC.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId node-id of the master, range 1 - 127, as configured in the
+ *               heartbeat consumers (0x1016) of the nodes
+ * @param period heartbeat period in ms, 0 to stop
+ * @return int -1 on error, 0 on success
+ */
+int coHeartbeatProducer(co_t *co, uint8_t nodeId, uint16_t period);
+#endif
+
+#ifdef CO_NODE_GUARDING_ENABLE
+/**
+ * @brief Start or stop node guarding of a node.
+ *
+ * Guard time and life time factor should be the same as configured in the
+ * node (0x100C and 0x100D). Guarding requests are sent by coSYNC(), answers
+ * are processed wherever frames are received, e.g. coRPDO().
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId node to guard
+ * @param guardTime time in ms between guarding requests, 0 to stop guarding
+ * @param lifeTimeFactor node is lost if it didn't answer for guardTime *
+ *                       lifeTimeFactor, at least 1
+ * @return int -1 on error i.e. CO_GUARD_NODES exhausted, 0 on success
+ */
+int coGuardRegister(co_t *co, uint8_t nodeId, uint16_t guardTime, uint8_t lifeTimeFactor);
+#endif
+
+#ifdef CO_RECOVERY_ENABLE
+/**
+ * @brief Check CAN controller state and recover from bus-off.
+ *
+ * Is called by coSYNC(), only needs to be called directly if the application
+ * doesn't send SYNCs. Once the controller is back the nodes are resynchronized,
+ * if that fails, e.g. on a full transmit queue, it is repeated with the next
+ * call.
+ *
+ * @param[in] co coSimple instance
+ * @return int -1 on error or while bus-off or resynchronizing, 0 on bus is usable
+ */
+int coBusCheck(co_t *co);
+#endif
+
+#ifdef CO_SYNC_COUNTER_ENABLE
+/**
+ * @brief Reset internal SYNC counter.
+ *
+ * @note This needs to be called once before calling coSYNC the first time and
+ *       again after communication has been stopped and started again.
+ *
+ * @param[in] co coSimple instance
+ * @return int -1 on error, 0 on success
+ */
+int coSYNCResetCounter(co_t *co);
+#endif
+
+/**
+ * @brief Send Timestamp broadcast.
+ *
+ * @note Only milliseconds of timestamp is implemented, field for days is set to
+ *       zero!
+ *
+ * @param[in] co coSimple instance
+ * @param ms the milliceconds count to use, if CO_TIME_USE_TIMECB then the
+ *           co_time_cb_t time callback is used for the actual value
+ * @return int -1 on error, 0 on success
+ */
+int coTIME(co_t *co, uint32_t ms);
+
+/**
+ * @brief Send PDO to a node.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @param[in] data PDO data in network byte order, LSB first!
+ * @param len size of data array, range 1 - 8
+ * @return int -1 on error, 0 on success
+ */
+int coTPDO(co_t *co, uint8_t nodeId, uint8_t *data, size_t len);
+
+/**
+ * @brief Send PDOs to many nodes at once.
+ *
+ * All frames are prepared first and then handed over to the co_tx_batch_cb_t
+ * callback in one call (in chunks of at most CO_TPDO_BATCH frames), or sent
+ * one after another with co_tx_cb_t if no batch callback is set. Call directly
+ * after coSYNC() so that all nodes receive their data within a short window.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] nodeIds addressed node of each PDO
+ * @param[in] data PDO data in network byte order, LSB first! Data of PDO i
+ *                 starts at data + i * stride.
+ * @param stride distance in bytes between the data of two PDOs
+ * @param len size of data of each PDO, range 1 - 8
+ * @param n count of PDOs
+ * @return int -1 on error, 0 on success
+ */
+int coTPDOBatch(co_t *co, const uint8_t *nodeIds, const uint8_t *data, size_t stride, size_t len, size_t n);
+
+/**
+ * @brief Receive PDO from a node.
+ *
+ * @note Call is non-blocking! Check return code.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @param[in,out] data PDO data in network byte order, LSB first!
+ *                     data array is owned by application
+ * @param[out] len size of data array, range 1 - 8
+ * @return int -1 on error, 0 on success, 1 on no data
+ */
+int coRPDO(co_t *co, uint8_t nodeId, uint8_t *data, size_t *len);
+
+/**
+ * @brief Write value to SDO server.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @param index object dictionary index
+ * @param subIndex od subindex
+ * @param data value to be set
+ * @param len size of data in \p data
+ * @return uint32_t 0 on success, SDO abort code on error
+ */
+uint32_t coSDOWrite(co_t *co, uint8_t nodeId, uint16_t index, uint8_t subIndex, uint32_t data, size_t len);
+
+#define coSDOWriteU32(co, nodeId, index, subIndex, data) \
+    coSDOWrite(co, nodeId, index, subIndex, (uint32_t)data, sizeof(uint32_t))
+#define coSDOWriteI32(co, nodeId, index, subIndex, data) \
+    coSDOWrite(co, nodeId, index, subIndex, (uint32_t)data, sizeof(int32_t))
+#define coSDOWriteU16(co, nodeId, index, subIndex, data) \
+    coSDOWrite(co, nodeId, index, subIndex, (uint32_t)data, sizeof(uint16_t))
+#define coSDOWriteI16(co, nodeId, index, subIndex, data) \
+    coSDOWrite(co, nodeId, index, subIndex, (uint32_t)data, sizeof(int16_t))
+#define coSDOWriteU8(co, nodeId, index, subIndex, data) \
+    coSDOWrite(co, nodeId, index, subIndex, (uint32_t)data, sizeof(uint8_t))
+#define coSDOWriteI8(co, nodeId, index, subIndex, data) \
+    coSDOWrite(co, nodeId, index, subIndex, (uint32_t)data, sizeof(int8_t))
+
+/**
+ * @brief Read value from SDO server.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @param index object dictionary index
+ * @param subIndex od subindex
+ * @param[out] data read value
+ * @param len size of data in \p data
+ * @return uint32_t 0 on success, SDO abort code on error
+ */
+uint32_t coSDORead(co_t *co, uint8_t nodeId, uint16_t index, uint8_t subIndex, uint32_t *data, size_t len);
+
+#define coSDOReadU32(co, nodeId, index, subIndex, data) \
+    coSDORead(co, nodeId, index, subIndex, (uint32_t *)data, sizeof(uint32_t))
+#define coSDOReadI32(co, nodeId, index, subIndex, data) \
+    coSDORead(co, nodeId, index, subIndex, (uint32_t *)data, sizeof(int32_t))
+#define coSDOReadU16(co, nodeId, index, subIndex, data) \
     coSDORead(co, nodeId, index, subIndex, (uint32_t *)data, sizeof(uint16_t))
 #define coSDOReadI16(co, nodeId, index, subIndex, data) \
     coSDORead(co, nodeId, index, subIndex, (uint32_t *)data, sizeof(int16_t))
@@ -284,5 +1651,931 @@ uint32_t coSDORead(co_t *co, uint8_t nodeId, uint16_t index, uint8_t subIndex, u
 #define coSDOReadI8(co, nodeId, index, subIndex, data) \
     coSDORead(co, nodeId, index, subIndex, (uint32_t *)data, sizeof(int8_t))
 
+/**
+ * @brief Write a configuration to SDO server.
+ *
+ * Entries are written in order, the first failing write aborts the batch.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @param[in] cfg array of configuration entries
+ * @param n count of entries in \p cfg
+ * @return uint32_t 0 on success, SDO abort code on error
+ */
+uint32_t coSDOWriteBatch(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, size_t n);
+
+/**
+ * @brief Calculate fingerprint of a configuration.
+ *
+ * 32-bit FNV-1a hash over all entries. Never zero, as CiA301 uses zero in the
+ * verify configuration object 0x1020 for "not configured".
+ *
+ * @param[in] cfg array of configuration entries
+ * @param n count of entries in \p cfg
+ * @return uint32_t fingerprint of the configuration
+ */
+uint32_t coSDOConfigFingerprint(const co_sdo_cfg_t *cfg, size_t n);
+
+/**
+ * @brief Configure a node, but only if its configuration differs.
+ *
+ * The fingerprint of the configuration is compared against the verify
+ * configuration object 0x1020 of the node (sub 1 "date" holds the fingerprint,
+ * sub 2 "time" the count of entries). If both match the node is already
+ * configured and nothing is written. Otherwise 0x1020 is cleared, the
+ * configuration written and then 0x1020 set to the new fingerprint. Nodes
+ * without a readable 0x1020 are simply always configured.
+ *
+ * @note A node only keeps 0x1020 over a power cycle if it stores it together
+ *       with the rest of its configuration (0x1010), which keeps them in sync.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @param[in] cfg array of configuration entries
+ * @param n count of entries in \p cfg
+ * @return int -1 on error, 0 on configured, 1 on skipped as already configured
+ */
+int coSDOConfigure(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, size_t n);
+
+#ifdef CO_SDO_ASYNC_ENABLE
+/**
+ * @brief Write a configuration to SDO server in the background.
+ *
+ * Call returns immediately, the transfer is driven by coRPDO() and coSYNC().
+ * Once done co_sdo_done_cb_t gets called. Entries are written in order, the
+ * first failing write aborts the batch.
+ *
+ * @note \p cfg must stay valid until the transfer is done.
+ * @note Don't mix with blocking SDO transfers to the same node.
+ * @note With CO_SDO_CHANNELS_ENABLE one transfer per channel of the node.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @param[in] cfg array of configuration entries
+ * @param n count of entries in \p cfg, at least one
+ * @return int -1 on error or if no transfer is available, 0 on started
+ */
+int coSDOWriteBatchAsync(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, size_t n);
+
+/**
+ * @brief Check if a background SDO transfer to a node is active.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @return int 0 on idle, 1 on busy
+ */
+int coSDOAsyncBusy(co_t *co, uint8_t nodeId);
+#endif
+
+#ifdef CO_SDO_CHANNELS_ENABLE
+/**
+ * @brief Configure and register an additional SDO channel of a node.
+ *
+ * Writes the COB-IDs to the SDO server parameter 0x1200 + \p n of the node
+ * over the default channel. Both COB-IDs have to be in 0x680 - 0x6DF, the
+ * range the predefined connection set and CiA 301 leave free, and must not be
+ * used by another channel.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @param n SDO server channel of the node, range 1 - 127
+ * @param request COB-ID of requests, client to server
+ * @param response COB-ID of responses, server to client
+ * @return int -1 on error i.e. COB-ID in use, node doesn't offer the channel or no space left, 0 on success
+ */
+int coSDOChannelAdd(co_t *co, uint8_t nodeId, uint8_t n, uint16_t request, uint16_t response);
+
+/**
+ * @brief Forget the additional SDO channels of a node.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ */
+void coSDOChannelForget(co_t *co, uint8_t nodeId);
+
+/**
+ * @brief Read many values from SDO server at once.
+ *
+ * Keeps one request in flight on every channel of the node, so n values take
+ * about n / channels round trips.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @param[in] cfg index, subindex and size of each value, data is ignored
+ * @param[out] data read values
+ * @param n count of values
+ * @return uint32_t 0 on success, SDO abort code on error
+ */
+uint32_t coSDOReadParallel(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, uint32_t *data, size_t n);
+
+/**
+ * @brief Write many values to SDO server at once.
+ *
+ * Like coSDOWriteBatch() but with one request in flight on every channel of
+ * the node. Writes may complete in any order, so use only for entries that
+ * don't depend on each other.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId addressed node
+ * @param[in] cfg array of entries to write
+ * @param n count of entries in \p cfg
+ * @return uint32_t 0 on success, SDO abort code on error
+ */
+uint32_t coSDOWriteParallel(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, size_t n);
+#endif
+
+#ifdef CO_HOTPLUG_ENABLE
+/**
+ * @brief Register configuration of a node for hot-plug.
+ *
+ * Once the node sends a boot-up message during cyclic operation it gets
+ * configured in the background and set to operational.
+ * Registering the same node again replaces its configuration.
+ *
+ * @note \p cfg must stay valid while the node is registered.
+ *
+ * @param[in] co coSimple instance
+ * @param nodeId node to register
+ * @param[in] cfg array of configuration entries
+ * @param n count of entries in \p cfg, at least one
+ * @return int -1 on error i.e. CO_HOTPLUG_NODES exhausted, 0 on success
+ */
+int coHotplugRegister(co_t *co, uint8_t nodeId, const co_sdo_cfg_t *cfg, size_t n);
+#endif
+
+#ifdef CO_CIA402_ENABLE
+/**
+ * @brief CiA402 power state machine states
+ *
+ * @see co402Update()
+ */
+typedef enum co_402_state_e {
+    CO_402_NOT_READY = 0,          //<! not ready to switch on
+    CO_402_SWITCH_ON_DISABLED = 1, //<! switch on disabled
+    CO_402_READY = 2,              //<! ready to switch on
+    CO_402_SWITCHED_ON = 3,        //<! switched on
+    CO_402_OP_ENABLED = 4,         //<! operation enabled
+    CO_402_QUICK_STOP = 5,         //<! quick stop active
+    CO_402_FAULT_REACTION = 6,     //<! fault reaction active
+    CO_402_FAULT = 7               //<! fault
+} co_402_state_t;
+
+/**
+ * @brief CiA402 state an axis should be brought to
+ *
+ * @see co402Update()
+ */
+typedef enum co_402_target_e {
+    CO_402_TARGET_DISABLED = 0,  //<! switch on disabled, power stage off
+    CO_402_TARGET_ENABLED = 1,   //<! operation enabled, faults are reset
+    CO_402_TARGET_QUICK_STOP = 2 //<! quick stop, then switch on disabled
+} co_402_target_t;
+
+/**
+ * @brief Step the CiA402 power state machine of many axes.
+ *
+ * Decodes the state of every axis from its statusword and sets the command
+ * bits of its controlword that lead one step closer to the target state. Call
+ * once per cycle with the received statuswords, before sending the
+ * controlwords. A drive in fault gets a fault reset if its target is enabled,
+ * the reset bit is toggled each call to generate the required rising edge.
+ *
+ * Only the command bits 0 - 3 and 7 of the controlwords are modified, the
+ * operation mode specific bits and halt are left to the application.
+ *
+ * @param[in] statusword statusword (0x6041) of each axis
+ * @param[in,out] controlword controlword (0x6040) of each axis
+ * @param[in] target requested co_402_target_t of each axis
+ * @param[in,out] state decoded co_402_state_t of each axis, holds previous
+ *                      state on input, must be initialized once
+ * @param n count of axes
+ * @return size_t count of axes whose state changed since the last call
+ */
+size_t co402Update(const uint16_t *restrict statusword, uint16_t *restrict controlword,
+                   const uint8_t *restrict target, uint8_t *restrict state, size_t n);
+#endif
+
+#ifdef CO_SETPOINT_ENABLE
+/**
+ * @brief Policy on setpoint FIFO underrun
+ *
+ * @see coSetpointPop()
+ */
+typedef enum co_sp_policy_e {
+    CO_SP_HOLD = 0,       //<! repeat the last setpoint
+    CO_SP_EXTRAPOLATE = 1 //<! continue with the last velocity, then hold
+} co_sp_policy_t;
+
+/**
+ * @brief Setpoint FIFO of one axis
+ *
+ * Zero initialize and set the policy, then only use through the API.
+ */
+typedef struct co_setpoint_s {
+    int32_t fifo[CO_SETPOINT_FIFO]; //<! buffered setpoints
+    atomic_uint head;               //<! next write position, only written by producer
+    atomic_uint tail;               //<! next read position, only written by consumer
+    int32_t last;                   //<! last setpoint returned by coSetpointPop()
+    int32_t delta;                  //<! difference of the last two returned setpoints
+    uint32_t underruns;             //<! count of coSetpointPop() calls with empty FIFO
+    uint8_t missed;                 //<! count of consecutive underruns
+    uint8_t primed;                 //<! delta is valid
+    uint8_t policy;                 //<! co_sp_policy_t on underrun
+} co_setpoint_t;
+
+/**
+ * @brief Add a setpoint to the FIFO of an axis.
+ *
+ * @note Only to be called from the single producer.
+ *
+ * @param[in,out] sp setpoint FIFO of axis
+ * @param position target position to add
+ * @return int -1 on FIFO full, 0 on success
+ */
+int coSetpointPush(co_setpoint_t *sp, int32_t position);
+
+/**
+ * @brief Get count of setpoints that can still be added.
+ *
+ * @param[in] sp setpoint FIFO of axis
+ * @return size_t count of free entries
+ */
+size_t coSetpointFree(co_setpoint_t *sp);
+
+/**
+ * @brief Take the setpoint for the current cycle from the FIFO of an axis.
+ *
+ * Call exactly once per SYNC. If the FIFO is empty a setpoint according to the
+ * policy is returned instead.
+ *
+ * @note Only to be called from the single consumer.
+ *
+ * @param[in,out] sp setpoint FIFO of axis
+ * @param[out] position target position for this cycle
+ * @return int 0 on setpoint from FIFO, 1 on underrun
+ */
+int coSetpointPop(co_setpoint_t *sp, int32_t *position);
+#endif
+
+#ifdef CO_SHM_ENABLE
+#define CO_SHM_MAGIC (0x636f5348) //<! "coSH", identifies a co_shm_t
+#define CO_SHM_LAYOUT (2)         //<! layout version of co_shm_t
+
+/**
+ * @brief Process image in shared memory
+ *
+ * Header is followed by the NMT node state table (nodesLen bytes), the receive
+ * timestamps of the last PDO of every node (tsLen bytes, uint64_t in ns, index
+ * is nodeId - 1) and the process image (imageLen bytes). Sequence is odd while
+ * the writer updates the data, every publish increments it by two.
+ */
+typedef struct co_shm_s {
+    uint32_t magic;    //<! CO_SHM_MAGIC once initialized
+    uint32_t layout;   //<! CO_SHM_LAYOUT of the writer
+    atomic_uint seq;   //<! seqlock sequence
+    uint32_t nodesLen; //<! size in bytes of node state table, 0 if not included
+    uint32_t tsLen;    //<! size in bytes of PDO timestamps, 0 if not included
+    uint32_t imageLen; //<! size in bytes of process image
+    uint8_t data[];    //<! node state table, PDO timestamps and process image
+} co_shm_t;
+
+/**
+ * @brief Get the size a co_shm_t needs.
+ *
+ * @param imageLen size of the process image in bytes
+ * @return size_t size in bytes to allocate / map for the co_shm_t
+ */
+size_t coShmSize(size_t imageLen);
+
+/**
+ * @brief Initialize shared memory for publishing.
+ *
+ * @param[out] shm memory of at least coShmSize() bytes
+ * @param imageLen size of the process image in bytes
+ * @return int -1 on error, 0 on success
+ */
+int coShmInit(co_shm_t *shm, size_t imageLen);
+
+/**
+ * @brief Publish a consistent snapshot of the process image.
+ *
+ * Call from the single writer, e.g. after every cycle.
+ *
+ * @param[in] co coSimple instance
+ * @param[in,out] shm initialized shared memory
+ * @param[in] image process image of imageLen bytes
+ */
+void coShmPublish(co_t *co, co_shm_t *shm, const void *image);
+
+/**
+ * @brief Read a consistent snapshot of the process image.
+ *
+ * Retries up to CO_SHM_READ_RETRIES times while the writer is updating the
+ * data. Never blocks the writer.
+ *
+ * @param[in] shm shared memory initialized by the writer
+ * @param[out] image buffer of imageLen bytes for the process image
+ * @param[out] nodes buffer of nodesLen bytes for the node table, may be NULL
+ * @param[out] pdoTs buffer of tsLen bytes for the PDO timestamps, may be NULL
+ * @param[out] version count of publishes of the snapshot, may be NULL
+ * @return int -1 on error i.e. not initialized or other layout, 0 on success,
+ *             1 on busy i.e. writer didn't finish or died while updating
+ */
+int coShmRead(const co_shm_t *shm, void *image, void *nodes, void *pdoTs, uint32_t *version);
+#endif
+
+#if defined(CO_MUX_ENABLE) || defined(CO_BLOG_ENABLE)
+/**
+ * @brief Add a frame to a ring.
+ *
+ * @note Only to be called from the single producer.
+ *
+ * @param[in,out] ring the ring
+ * @param[in] msg the frame to add
+ * @return int -1 on ring full, 0 on success
+ */
+int coRingTx(co_ring_t *ring, const co_msg_t *msg);
+
+/**
+ * @brief Take a frame from a ring.
+ *
+ * Same semantics as co_rx_cb_t.
+ *
+ * @note Only to be called from the single consumer.
+ *
+ * @param[in,out] ring the ring
+ * @param[out] msg the taken frame
+ * @return int 0 on success, 1 on ring empty
+ */
+int coRingRx(co_ring_t *ring, co_msg_t *msg);
+#endif
+
+#ifdef CO_MUX_ENABLE
+/**
+ * @brief Attach a client to a bus-sharing daemon.
+ *
+ * Rings of the client are reset. Received frames are forwarded to it as soon
+ * as it sets its active flag.
+ *
+ * @param[in,out] mux the daemon
+ * @param[in,out] client the client, typically in shared memory
+ * @return int -1 on error i.e. CO_MUX_CLIENTS exhausted, 0 on success
+ */
+int coMuxAttach(co_mux_t *mux, co_mux_client_t *client);
+
+/**
+ * @brief Detach a client from a bus-sharing daemon.
+ *
+ * SDO channels owned by the client are released.
+ *
+ * @param[in,out] mux the daemon
+ * @param[in] client the client
+ */
+void coMuxDetach(co_mux_t *mux, co_mux_client_t *client);
+
+/**
+ * @brief Send frames of all clients to the bus.
+ *
+ * Call regularly in the daemon, e.g. after every cycle. Frames received from
+ * the bus are forwarded to the clients wherever coSimple receives them, if
+ * co_t::mux is set.
+ *
+ * @param[in] co coSimple instance that owns the bus
+ * @param[in,out] mux the daemon
+ * @return int -1 on error, 0 on success
+ */
+int coMuxPoll(co_t *co, co_mux_t *mux);
+#endif
+
+#ifdef CO_ROUTER_ENABLE
+/**
+ * @brief Add a route to a router or change an existing one.
+ *
+ * @param[in,out] router the router
+ * @param from COB-ID to forward, range 0 - 0x7ff
+ * @param to COB-ID on the other bus, range 0 - 0x7ff
+ * @return int -1 on error i.e. CO_ROUTES exhausted, 0 on success
+ */
+int coRouteAdd(co_router_t *router, uint16_t from, uint16_t to);
+
+/**
+ * @brief Remove a route from a router.
+ *
+ * @param[in,out] router the router
+ * @param from COB-ID that is forwarded
+ * @return int -1 on error i.e. no such route, 0 on success
+ */
+int coRouteDel(co_router_t *router, uint16_t from);
+#endif
+
+#ifdef CO_REPLAY_ENABLE
+/**
+ * @brief Read the next frame of a candump or ASC log.
+ *
+ * Understands the candump log format "(1436509052.249713) can0 123#DEADBEEF"
+ * and ASC lines like "0.012345 1 123 Rx d 2 DE AD". Lines that are no frame
+ * e.g. headers, comments, error frames, extended or FD frames are skipped.
+ *
+ * @param[in,out] log the log
+ * @param[out] msg the frame, with CO_MSG_TIMESTAMP_ENABLE ts is set too
+ * @param[out] ts timestamp of the frame in ns
+ * @param[out] master frame was sent by the master, from the direction in ASC
+ *                    logs or by its COB-ID in candump logs
+ * @return int 0 on success, 1 on end of log
+ */
+int coLogNext(co_log_t *log, co_msg_t *msg, uint64_t *ts, uint8_t *master);
+
+/**
+ * @brief Continue reading a log at a position.
+ *
+ * @param[in,out] log the log
+ * @param pos start of a line, or of a block of a binary log, e.g.
+ *            co_log_t::framePos or co_trace_ref_t::pos
+ */
+void coLogSeek(co_log_t *log, size_t pos);
+
+/**
+ * @brief Start the replay of a log.
+ *
+ * @param[out] replay the replay
+ * @param[in] data the log, typically a memory mapped file, needs no termination
+ * @param len size of the log
+ * @param ms clock for pacing, NULL to replay as fast as possible
+ * @param speed acceleration, 1 for original time
+ */
+void coReplayInit(co_replay_t *replay, const char *data, size_t len, co_time_cb_t ms, uint32_t speed);
+
+/**
+ * @brief Get the next recorded frame once it is due.
+ *
+ * Same semantics as co_rx_cb_t.
+ *
+ * @param[in,out] replay the replay
+ * @param[out] msg the recorded frame
+ * @return int 0 on success, 1 on frame not yet due or end of log
+ */
+int coReplayRx(co_replay_t *replay, co_msg_t *msg);
+
+/**
+ * @brief Compare a sent frame with the recording.
+ *
+ * Same semantics as co_tx_cb_t, the frame is not sent anywhere.
+ *
+ * @param[in,out] replay the replay
+ * @param[in] msg the frame sent by coSimple
+ * @return int 0 on success
+ */
+int coReplayTx(co_replay_t *replay, const co_msg_t *msg);
+
+/**
+ * @brief Finish a replay and count the recorded frames that were not sent.
+ *
+ * @param[in,out] replay the replay
+ * @return uint32_t count of differences, 0 if sent frames equal the recording
+ */
+uint32_t coReplayFinish(co_replay_t *replay);
+#endif
+
+#ifdef CO_TRACE_ENABLE
+/**
+ * @brief Split a log into parts for parallel analysis.
+ *
+ * Parts start at the beginning of a line and are roughly of equal size.
+ *
+ * @param[in] data the log
+ * @param len size of the log
+ * @param n requested count of parts
+ * @param[out] offsets n + 1 entries, part i ranges from offsets[i] to offsets[i + 1]
+ * @return size_t count of parts, lower than n if the log has too few lines
+ */
+size_t coLogSplit(const char *data, size_t len, size_t n, size_t *offsets);
+
+/**
+ * @brief Analyze a log or a part of it in one pass.
+ *
+ * Can be called repeatedly to continue with further data.
+ *
+ * @param[in,out] trace statistics to add to
+ * @param[in,out] log the log, is read to its end
+ */
+void coTraceAnalyze(co_trace_t *trace, co_log_t *log);
+
+/**
+ * @brief Account the SYNC cycle still open at the end of a log.
+ *
+ * The cycle only counts if the log goes on for at least one SYNC period
+ * after the last SYNC, a log cut right after a SYNC is no missed cycle.
+ *
+ * @param[in,out] trace statistics of the whole log, or merged of all parts
+ */
+void coTraceFinish(co_trace_t *trace);
+
+/**
+ * @brief Merge statistics of a later part of a log.
+ *
+ * Cycles spanning the border of both parts are not accounted. Parts have to
+ * be merged in order. The index of part is appended to the one of trace if
+ * it fits completely, else trace keeps the index of the frames so far.
+ *
+ * @param[in,out] trace statistics to merge into
+ * @param[in] part statistics of the later part
+ */
+void coTraceMerge(co_trace_t *trace, const co_trace_t *part);
+#endif
+
+#ifdef CO_BLOG_ENABLE
+/**
+ * @brief Record a frame in a binary log.
+ *
+ * @note Only to be called from a single thread, the receive path of a co_t
+ *       with co_t::blog set counts as a call.
+ *
+ * @param[in,out] blog the binary log
+ * @param[in] msg the frame, with timestamp
+ * @return int -1 on error i.e. frame dropped, 0 on success
+ */
+int coBlogRecord(co_blog_t *blog, const co_msg_t *msg);
+
+/**
+ * @brief Encode recorded frames and store full blocks.
+ *
+ * Call regularly, e.g. from a background thread of the application.
+ *
+ * @param[in,out] blog the binary log
+ * @return int -1 on error while storing a block, count of encoded frames otherwise
+ */
+int coBlogWork(co_blog_t *blog);
+
+/**
+ * @brief Store the partially filled block, e.g. before shutdown.
+ *
+ * @note Only to be called from the thread that calls coBlogWork().
+ *
+ * @param[in,out] blog the binary log
+ * @return int -1 on error, 0 on success
+ */
+int coBlogFlush(co_blog_t *blog);
+
+/**
+ * @brief Build the block index of a binary log.
+ *
+ * Only the block headers are read. To seek, look up the last block starting
+ * before the wanted time and read from its offset with coLogNext().
+ *
+ * @param[in] data the binary log
+ * @param len size of the log
+ * @param[out] offsets offset of each block, may be NULL to just count
+ * @param[out] ts timestamp in ns of the first frame of each block, may be NULL
+ * @param n size of offsets and ts
+ * @return size_t count of blocks in the log
+ */
+size_t coBlogIndex(const void *data, size_t len, size_t *offsets, uint64_t *ts, size_t n);
+#endif
+
+#ifdef CO_FAULT_ENABLE
+/**
+ * @brief Start fault injection, rules are timed relative to now.
+ *
+ * @param[in,out] fault the wrapper
+ */
+void coFaultInit(co_fault_t *fault);
+
+/**
+ * @brief Receive a frame through the wrapper.
+ *
+ * Same semantics as co_rx_cb_t.
+ *
+ * @param[in,out] fault the wrapper
+ * @param[out] msg the received CAN frame
+ * @return int -1 on error, 0 on successful reception, 1 on no data
+ */
+int coFaultRx(co_fault_t *fault, co_msg_t *msg);
+
+/**
+ * @brief Send a frame through the wrapper.
+ *
+ * Same semantics as co_tx_cb_t.
+ *
+ * @param[in,out] fault the wrapper
+ * @param[in] msg the CAN frame to send
+ * @return int -1 on error, 0 on successful sending
+ */
+int coFaultTx(co_fault_t *fault, const co_msg_t *msg);
+
+/**
+ * @brief Get the controller status through the wrapper.
+ *
+ * Same semantics as co_status_cb_t, reports bus-off while injected.
+ *
+ * @param[in,out] fault the wrapper
+ * @param[out] status current status of the controller
+ * @return int -1 on error, 0 on success
+ */
+int coFaultStatus(co_fault_t *fault, co_bus_status_t *status);
+
+/**
+ * @brief Restart the controller through the wrapper.
+ *
+ * Same semantics as co_restart_cb_t, ends an injected bus-off.
+ *
+ * @param[in,out] fault the wrapper
+ * @return int -1 on error, 0 on success
+ */
+int coFaultRestart(co_fault_t *fault);
+#endif
+
+#ifdef CO_RTA_ENABLE
+/**
+ * @brief Compute worst-case response times of frames.
+ *
+ * The SYNC frame is added to the set by itself. Acyclic traffic (NMT, EMCY,
+ * SDO, heartbeat, ...) is given as bus time per SYNC period and is
+ * conservatively treated as interfering with all frames.
+ *
+ * @param[in,out] frames frames to analyze, responseUs is set
+ * @param n count of frames
+ * @param bitrate bitrate of the bus in bit/s
+ * @param syncPeriodUs SYNC period in us
+ * @param acyclicUs bus time in us per SYNC period reserved for acyclic traffic
+ * @return int -1 on error, 0 on all frames meet their deadline, count of frames that don't otherwise
+ */
+int coRTA(co_rta_frame_t *frames, size_t n, uint32_t bitrate, uint32_t syncPeriodUs, uint32_t acyclicUs);
+
+/**
+ * @brief Find the shortest SYNC period for which all frames meet their deadlines.
+ *
+ * The response times of the frames at the returned period are set.
+ *
+ * @param[in,out] frames frames to analyze, responseUs is set
+ * @param n count of frames
+ * @param bitrate bitrate of the bus in bit/s
+ * @param acyclicUs bus time in us per SYNC period reserved for acyclic traffic
+ * @return uint32_t shortest feasible SYNC period in us, 0 if none up to one second
+ */
+uint32_t coRTAMinSyncPeriod(co_rta_frame_t *frames, size_t n, uint32_t bitrate, uint32_t acyclicUs);
+#endif
+
+#ifdef CO_REDUNDANT_ENABLE
+/**
+ * @brief Start redundant operation, clears statistics.
+ *
+ * @param[in,out] red the wrapper
+ */
+void coRedundantInit(co_redundant_t *red);
+
+/**
+ * @brief Receive a frame from either bus.
+ *
+ * Same semantics as co_rx_cb_t. Returns the first copy of every frame, copies
+ * received later on the other bus are dropped.
+ *
+ * @param[in,out] red the wrapper
+ * @param[out] msg the received CAN frame
+ * @return int -1 on error of both buses, 0 on successful reception, 1 on no data
+ */
+int coRedundantRx(co_redundant_t *red, co_msg_t *msg);
+
+/**
+ * @brief Send a frame on both buses.
+ *
+ * Same semantics as co_tx_cb_t.
+ *
+ * @param[in,out] red the wrapper
+ * @param[in] msg the CAN frame to send
+ * @return int -1 if it failed on both buses, 0 on successful sending on at least one
+ */
+int coRedundantTx(co_redundant_t *red, const co_msg_t *msg);
+
+/**
+ * @brief Get the status of the better bus.
+ *
+ * Same semantics as co_status_cb_t. A bus that is off while the other one
+ * still works is restarted right away.
+ *
+ * @param[in,out] red the wrapper
+ * @param[out] status status of the better controller
+ * @return int -1 on error of both buses, 0 on success
+ */
+int coRedundantStatus(co_redundant_t *red, co_bus_status_t *status);
+
+/**
+ * @brief Restart both controllers.
+ *
+ * Same semantics as co_restart_cb_t.
+ *
+ * @param[in,out] red the wrapper
+ * @return int -1 if both failed, 0 on success
+ */
+int coRedundantRestart(co_redundant_t *red);
+#endif
+
+#ifdef CO_STANDBY_ENABLE
+/**
+ * @brief Get the max size of a snapshot.
+ *
+ * @param imageLen size of the process image in bytes
+ * @return size_t max size in bytes of a snapshot
+ */
+size_t coSnapshotSize(size_t imageLen);
+
+/**
+ * @brief Serialize the runtime state and the process image.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] image process image of imageLen bytes
+ * @param imageLen size of the process image in bytes
+ * @param[out] buf buffer for the snapshot
+ * @param len size of buf, at least coSnapshotSize()
+ * @return size_t size in bytes of the snapshot, 0 if buf is too small
+ */
+size_t coSnapshotSave(const co_t *co, const void *image, size_t imageLen, uint8_t *buf, size_t len);
+
+/**
+ * @brief Restore the runtime state and the process image.
+ *
+ * The snapshot must come from a build with the same settings. Timers restart
+ * at the current time, so nodes get a full heartbeat or life time to show up
+ * again and the master heartbeat is sent with the next cycle.
+ *
+ * @param[in,out] co coSimple instance, with callbacks set
+ * @param[in] buf the snapshot
+ * @param len size of the snapshot in bytes
+ * @param[out] image buffer of imageLen bytes for the process image
+ * @param imageLen size of the process image in bytes
+ * @return int -1 on error i.e. malformed, other settings or image size, 0 on success
+ */
+int coSnapshotLoad(co_t *co, const uint8_t *buf, size_t len, void *image, size_t imageLen);
+
+/**
+ * @brief Get the size a co_standby_t needs.
+ *
+ * @param imageLen size of the process image in bytes
+ * @return size_t size in bytes to allocate / map for the co_standby_t
+ */
+size_t coStandbySize(size_t imageLen);
+
+/**
+ * @brief Initialize shared memory for replication to a standby.
+ *
+ * @param[out] standby memory of at least coStandbySize() bytes
+ * @param imageLen size of the process image in bytes
+ * @return int -1 on error, 0 on success
+ */
+int coStandbyInit(co_standby_t *standby, size_t imageLen);
+
+/**
+ * @brief Replicate a snapshot to the standby.
+ *
+ * Call from the active master after every cycle.
+ *
+ * @param[in] co coSimple instance
+ * @param[in,out] standby initialized shared memory
+ * @param[in] image process image of imageLen bytes
+ * @param imageLen size of the process image in bytes
+ * @return int -1 on error, 0 on success
+ */
+int coStandbyPublish(co_t *co, co_standby_t *standby, const void *image, size_t imageLen);
+
+/**
+ * @brief Mirror the state of the active master.
+ *
+ * Call from the standby master about every cycle. Restores the latest
+ * snapshot into the instance, never blocks the active master. The snapshot
+ * is copied to buf first and only restored once the copy is consistent. Once
+ * the active master stopped publishing for timeout ms, also if it died while
+ * publishing, the standby takes over: it starts to call coSYNC(), coRPDO()
+ * etc. and publishes snapshots itself. Choose a timeout a little above the
+ * cycle time.
+ *
+ * @param[in,out] co coSimple instance of the standby, with callbacks set
+ * @param[in] standby shared memory initialized by the active master
+ * @param[out] image buffer of imageLen bytes for the process image
+ * @param imageLen size of the process image in bytes
+ * @param[out] buf scratch buffer for a copy of the snapshot
+ * @param len size of buf, at least coSnapshotSize()
+ * @param timeout time in ms without new snapshot to take over
+ * @return int -1 on error i.e. not initialized, 0 on active master alive, 1 on take over
+ */
+int coStandbyFollow(co_t *co, const co_standby_t *standby, void *image, size_t imageLen, uint8_t *buf,
+                    size_t len, uint32_t timeout);
+#endif
+
+#ifdef CO_FIRMWARE_ENABLE
+/**
+ * @brief Start a program download.
+ *
+ * @note Don't mix with other SDO transfers to the same nodes until finished.
+ *
+ * @param[in] co coSimple instance
+ * @param[in,out] fw the download
+ * @return int -1 on error, 0 on started
+ */
+int coFirmwareStart(co_t *co, co_fw_t *fw);
+
+/**
+ * @brief Drive a program download.
+ *
+ * Call as often as possible until finished. Processes received frames and
+ * sends segments of all nodes interleaved for as long as co_tx_cb_t accepts
+ * them, a failing co_tx_cb_t is taken as full transmit queue. Other received
+ * frames are processed as usual.
+ *
+ * @param[in] co coSimple instance
+ * @param[in,out] fw the download
+ * @return int -1 on error of rx callback, 0 on all nodes finished, 1 on busy
+ */
+int coFirmwareWork(co_t *co, co_fw_t *fw);
+#endif
+
+#ifdef CO_MPDO_ENABLE
+/**
+ * @brief Write an object by destination address mode MPDO.
+ *
+ * Unconfirmed, the nodes don't answer and failures are not reported, other
+ * than by EMCY if the node chooses to.
+ *
+ * @param[in] co coSimple instance
+ * @param cobId COB-ID of the MPDO, as configured in the RPDO of the nodes
+ * @param nodeId addressed node, 0 for all nodes
+ * @param index object dictionary index
+ * @param subIndex od subindex
+ * @param data value to write
+ * @param len size of value in bytes, range 1 - 4
+ * @return int 0 on success, else the error of co_tx_cb_t
+ */
+int coMPDOWrite(co_t *co, uint16_t cobId, uint8_t nodeId, uint16_t index, uint8_t subIndex, uint32_t data,
+                size_t len);
+
+/**
+ * @brief Receive source address mode MPDOs on a COB-ID.
+ *
+ * Received frames with the COB-ID are no longer returned by coRPDO() but
+ * forwarded object by object to co_t.mpdo, if they match co_t.mpdoScan.
+ *
+ * @param[in] co coSimple instance
+ * @param cobId COB-ID of the MPDO, as configured in the TPDO of the producers
+ * @return int -1 on error i.e. no space left, 0 on success
+ */
+int coMPDOListen(co_t *co, uint16_t cobId);
+#endif
+
+#ifdef CO_GATEWAY_ENABLE
+/**
+ * @brief Parse a CiA309-3 command line.
+ *
+ * Syntax is "[seq] [[net] node] command", with the commands "r[ead] index sub
+ * type", "w[rite] index sub type value", "start", "stop", "preop[erational]",
+ * "reset node" and "reset comm[unication]". Numbers are decimal or hex with 0x
+ * prefix. Only net 1 exists.
+ *
+ * @param[in] line command line, needs no termination, trailing CR/LF allowed
+ * @param len length of line
+ * @param[out] cmd the parsed command
+ * @return int CiA309-3 error code, i.e. 100 unsupported, 101 syntax error, 105
+ *             no node, 106 unsupported net, 107 unsupported node, 0 on success
+ */
+int coGatewayParse(const char *line, size_t len, co_gw_cmd_t *cmd);
+
+/**
+ * @brief Execute a CiA309-3 command line.
+ *
+ * Errors and NMT commands are answered immediately into \p resp. SDO requests
+ * are queued and answered later through coGatewayResponse().
+ *
+ * @param[in] co coSimple instance
+ * @param[in] line command line, needs no termination
+ * @param len length of line
+ * @param[in] ctx application context returned with the response, e.g. connection
+ * @param[out] resp buffer for an immediate response line, including CR/LF
+ * @param respLen size of resp
+ * @return int -1 on error, 0 on request queued, length of immediate response otherwise
+ */
+int coGatewayRequest(co_t *co, const char *line, size_t len, void *ctx, char *resp, size_t respLen);
+
+/**
+ * @brief Get the next response of a finished SDO request.
+ *
+ * Responses are returned in order of completion, clients match them by the
+ * sequence number. Timeouts and retries are handled in here, so call it
+ * regularly. SDO responses are received wherever coSimple receives frames,
+ * e.g. in coRPDO().
+ *
+ * @param[in] co coSimple instance
+ * @param[out] ctx application context given with the request
+ * @param[out] resp buffer for the response line, including CR/LF
+ * @param respLen size of resp
+ * @return int -1 on error, 0 on no finished request, length of response otherwise
+ */
+int coGatewayResponse(co_t *co, void **ctx, char *resp, size_t respLen);
+
+/**
+ * @brief Discard all requests of a context, e.g. on a closed connection.
+ *
+ * @param[in] co coSimple instance
+ * @param[in] ctx application context given with the requests
+ */
+void coGatewayDiscard(co_t *co, void *ctx);
+#endif
+
 
 #endif /* #ifndef __COSIMPLE_H_ */
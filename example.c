@@ -74,6 +74,32 @@ size_t len;            //<! length of PDO response, should be = 8
 
 volatile bool rpdo_received = false;
 
+const co_sdo_cfg_t config[] = { //<! SDO configuration of the slave
+    // perform pdo mapping:
+    // setup TPDO1 mapping, status + position + current
+    CO_SDO_CFG_U32(0x1800, 0x01, 0xc00001ff), // invalidate TPDO1
+    CO_SDO_CFG_U32(0x1a00, 0x00, 0x00000000), // reset PDO mapping
+    CO_SDO_CFG_U32(0x1a00, 0x01, 0x60410010), // status word, uint16
+    CO_SDO_CFG_U32(0x1a00, 0x02, 0x60640020), // position actual, int32
+    CO_SDO_CFG_U32(0x1a00, 0x03, 0x60780010), // current actual, int16
+    CO_SDO_CFG_U32(0x1a00, 0x00, 0x00000003), // three mapped objects
+    CO_SDO_CFG_U32(0x1800, 0x02, 0x00000001), // set TPDO1 as synchronous on each SYNC
+    CO_SDO_CFG_U32(0x1800, 0x01, 0x400001ff), // activate TPDO1
+    // setup RPDO1 mapping, control + position
+    CO_SDO_CFG_U32(0x1400, 0x01, 0xc000027f), // invalidate RPDO1
+    CO_SDO_CFG_U32(0x1600, 0x00, 0x00000000), // reset PDO mapping
+    CO_SDO_CFG_U32(0x1600, 0x01, 0x60400010), // control word, uint16
+    CO_SDO_CFG_U32(0x1600, 0x02, 0x60c10120), // target position, int32
+    CO_SDO_CFG_U32(0x1600, 0x00, 0x00000002), // two mapped objects
+    CO_SDO_CFG_U32(0x1400, 0x02, 0x00000001), // set RPDO1 as synchronous on each SYNC
+    CO_SDO_CFG_U32(0x1400, 0x01, 0x4000027f), // activate RPDO1
+    // set operation mode
+    CO_SDO_CFG_U32(0x6060, 0x00, 7), // modes of operation, 7 = interpolated position
+    // additional custom settings
+    // CO_SDO_CFG_U16(<object-id>, <sub-index>, <data>),
+    // ...
+};
+
 
 /*
  * Function Definitions
@@ -103,31 +129,10 @@ int main() {
     errCnt -= coSDOReadU32(&co, CAN_ID, 0x1018, 0x04, &data); // read serial number (0x1018.4)
     printf("\nserial number: %u", data);
 
-    // perform pdo mapping:
-    // setup TPDO1 mapping, status + position + current
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1800, 0x01, 0xc00001ff); // invalidate TPDO1
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1a00, 0x00, 0x00000000); // reset PDO mapping
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1a00, 0x01, 0x60410010); // status word, uint16
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1a00, 0x02, 0x60640020); // position actual, int32
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1a00, 0x03, 0x60780010); // current actual, int16
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1a00, 0x00, 0x00000003); // three mapped objects
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1800, 0x02, 0x00000001); // set TPDO1 as synchronous on each SYNC
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1800, 0x01, 0x400001ff); // activate TPDO1
-    // setup RPDO1 mapping, control + position
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1400, 0x01, 0xc000027f); // invalidate RPDO1
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1600, 0x00, 0x00000000); // reset PDO mapping
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1600, 0x01, 0x60400010); // control word, uint16
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1600, 0x02, 0x60c10120); // target position, int32
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1600, 0x00, 0x00000002); // two mapped objects
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1400, 0x02, 0x00000001); // set RPDO1 as synchronous on each SYNC
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x1400, 0x01, 0x4000027f); // activate RPDO1
-
-    // set operation mode
-    errCnt -= coSDOWriteU32(&co, CAN_ID, 0x6060, 0x00, 7); // modes of operation, 7 = interpolated position
-
-    // additional custom settings
-    // coSDOWriteU16(&co, CAN_ID, <object-id>, <sub-index>, <data>);
-    // ...
+    // configure slave, skipped if slave still has this configuration
+    ret = coSDOConfigure(&co, CAN_ID, config, sizeof(config) / sizeof(config[0]));
+    errCnt += (0 > ret);
+    printf("\nconfiguration %s", 1 == ret ? "skipped" : "written");
 
     printf("\nConfiguration error count: %d\n", errCnt);
 
@@ -190,12 +195,17 @@ static int canRx(co_msg_t *msg) {
     // to detect timeouts. If no CAN frame is ready to be received (receive
     // buffer is empy) then simply return 1 for "no new data". Otherwise fill
     // the co_msg_t msg fields and return 0 for "new data".
+
+    // With CO_MSG_TIMESTAMP_ENABLE also fill msg->ts with the reception time
+    // in nanoseconds. Ideally this is a hardware timestamp of the CAN
+    // controller, on Linux SocketCAN it can be requested with SO_TIMESTAMPING.
     return 1;
 }
 
 static int canTx(const co_msg_t *msg) {
     // This is again device specific. Take fields cobId, len and the data array
     // from the given co_msg_t and construct a device specific CAN frame.
+    // With CO_NODE_GUARDING_ENABLE also the rtr field has to be respected.
 
     // This call can be built blocking or non-blocking. Implementation has to
     // ensure that an immediate second call to this function does handle the